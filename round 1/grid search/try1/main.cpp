@@ -8,9 +8,13 @@
  *    in ±10% around the base, in 1%-increments
  *    => total 21 steps each => 21^4 combos
  * 3) Runs EXACT SAME backtest logic as before 
- *    (no optimizations, no logic changes).
+ *    (no logic changes; rolling averages are streamed
+ *    through RollingWindow instead of re-summed).
  * 4) Multi-threaded. Reports progress every second, 
  *    overwriting a single console line. Shows top 3 combos so far.
+ * 5) --sample sobol|lhs [--samples N] [--seed S] [--shard i/N]
+ *    replaces the grid with a fixed budget of low-discrepancy
+ *    points over the same ±10% box.
  *********************************************************/
 #include <iostream>
 #include <fstream>
@@ -20,11 +24,17 @@
 #include <map>
 #include <cmath>
 #include <algorithm>
+#include <tuple>
 #include <thread>
 #include <mutex>
 #include <chrono>
 #include <atomic>
 #include <condition_variable>
+#include <cstdio>
+
+#include "../try2/include/RollingWindow.h"
+#include "../try2/include/ParamSampler.h"
+#include "../try2/include/WorkStealing.h"
 
 // We will reuse the naive logic from before, 
 // so let's put it in a function `runBacktest(...)` that returns final PnL.
@@ -39,34 +49,30 @@ static const int    POSITION_SIZE         = 100;  // stays fixed
 static const double FEES                  = 0.002; // fixed
 static const int    POSITION_LIMIT        = 100;  // fixed
 
+// One round-trip trade: entry tick, exit tick, side (+1/-1), profit
+struct TradeRecord {
+    int    entry_index;
+    int    exit_index;
+    int    side;
+    double profit;
+};
+
 // We'll store the entire CSV in vectors:
 static std::vector<int>    g_ticks;
 static std::vector<double> g_bids;
 static std::vector<double> g_asks;
 static int                 g_nrows = 0;
 
-// We copy/paste the naive approach from the old code:
-
-//------------------------------------
-// Rolling averages by naive summation
-//------------------------------------
-static double mean_of_last_N(const std::vector<double>& arr, int N)
-{
-    double sum = 0.0;
-    int sz = (int)arr.size();
-    for(int i = sz - N; i < sz; i++){
-        sum += arr[i];
-    }
-    return sum / N;
-}
-
 //------------------------------------
 // Helper to run the entire backtest
+//   trades: if given, cleared and filled with the closed trades;
+//   the fuzzer passes nothing, so exits never allocate
 //------------------------------------
 double runBacktest(int short_window, 
                    int waiting_period,
                    double hs_exit_change_threshold,
-                   double ma_turn_threshold)
+                   double ma_turn_threshold,
+                   std::vector<TradeRecord> *trades = nullptr)
 {
     // Strategy-state arrays (like "historical_data" in Python):
     std::vector<int>    timestamp;
@@ -80,6 +86,11 @@ double runBacktest(int short_window,
     std::vector<bool>   in_high_spread;
     // trade_profit we keep for reference
     std::vector<double> trade_profit;
+    if(trades) trades->clear();
+
+    // Streaming rolling windows over past mid prices (current tick excluded)
+    RollingWindow short_win(short_window);
+    RollingWindow long_win(LONG_WINDOW);
 
     // We'll keep them in function-scope (like global in Python).
     bool   in_position                = false;
@@ -89,6 +100,12 @@ double runBacktest(int short_window,
     int    high_spread_exit_index     = -1;
     double last_high_spread_exit_savg = 0.0;
 
+    // Open trade, set when the position leaves zero, so exits
+    // don't have to scan position_log backwards for the entry.
+    int    entry_index                = -1;
+    double entry_mid                  = 0.0;
+    int    entry_side                 = 0;
+
     // There's only one product "UEC" => position & cash
     int    pos  = 0;
     double cash = 0.0;
@@ -102,6 +119,7 @@ double runBacktest(int short_window,
         } else if(position_size < 0){
             pr = (entry_price - exit_price) * std::abs(position_size);
         }
+        if(trades) trades->push_back({entry_i, exit_i, entry_side, pr});
         return pr;
     };
 
@@ -131,14 +149,8 @@ double runBacktest(int short_window,
         double spr = a - b;
         bool hs = (spr >= HIGH_SPREAD_THRESHOLD);
 
-        double s_avg = NAN;
-        if((int)mid_price.size() >= short_window){
-            s_avg = mean_of_last_N(mid_price, short_window);
-        }
-        double l_avg = NAN;
-        if((int)mid_price.size() >= LONG_WINDOW){
-            l_avg = mean_of_last_N(mid_price, LONG_WINDOW);
-        }
+        double s_avg = short_win.mean();
+        double l_avg = long_win.mean();
 
         int order_quantity = 0;
         double trade_p = 0.0;
@@ -152,18 +164,7 @@ double runBacktest(int short_window,
                     if((current_position_extreme - s_avg) >= ma_turn_threshold){
                         // exit early
                         int exit_index = (int)timestamp.size();
-                        int entry_index = -1;
-                        for(int k = (int)position_log.size()-1; k >= 0; k--){
-                            if(position_log[k] == 0){
-                                entry_index = k+1;
-                                break;
-                            }
-                        }
-                        if(entry_index >= 0 && entry_index < exit_index){
-                            double ep = mid_price[entry_index];
-                            double xp = m;
-                            trade_p = record_trade_section(entry_index, exit_index, ep, xp, pos);
-                        }
+                        trade_p = record_trade_section(entry_index, exit_index, entry_mid, m, pos);
                         order_quantity = -pos;
                         in_position = false;
                         position_is_long = false;
@@ -177,18 +178,7 @@ double runBacktest(int short_window,
                 } else {
                     if((s_avg - current_position_extreme) >= ma_turn_threshold){
                         int exit_index = (int)timestamp.size();
-                        int entry_index = -1;
-                        for(int k = (int)position_log.size()-1; k >= 0; k--){
-                            if(position_log[k] == 0){
-                                entry_index = k+1;
-                                break;
-                            }
-                        }
-                        if(entry_index >= 0 && entry_index < exit_index){
-                            double ep = mid_price[entry_index];
-                            double xp = m;
-                            trade_p = record_trade_section(entry_index, exit_index, ep, xp, pos);
-                        }
+                        trade_p = record_trade_section(entry_index, exit_index, entry_mid, m, pos);
                         order_quantity = -pos;
                         in_position = false;
                         position_is_long = false;
@@ -238,18 +228,10 @@ double runBacktest(int short_window,
         }
         // CASE 3: in HS & have a position => close now
         else if(hs && pos != 0){
-            int exit_index = (int)timestamp.size();
-            int entry_index = -1;
-            for(int k = (int)position_log.size()-1; k >= 0; k--){
-                if(position_log[k] == 0){
-                    entry_index = k+1;
-                    break;
-                }
-            }
-            if(entry_index >= 0 && entry_index < exit_index){
-                double ep = mid_price[entry_index];
-                double xp = m;
-                trade_p = record_trade_section(entry_index, exit_index, ep, xp, pos);
+            // (0) may already have closed this trade on the same tick
+            if(in_position){
+                int exit_index = (int)timestamp.size();
+                trade_p = record_trade_section(entry_index, exit_index, entry_mid, m, pos);
             }
             order_quantity = -pos;
             in_position = false;
@@ -286,11 +268,18 @@ double runBacktest(int short_window,
             cash += b * (-actual_order) * (1.0 - FEES);
         }
         new_pos = pos + actual_order; // final position
+        if(pos == 0 && new_pos != 0){
+            entry_index = i;
+            entry_mid   = m;
+            entry_side  = (new_pos > 0) ? 1 : -1;
+        }
 
         // Now record to history
         double use_savg = std::isnan(s_avg) ? m : s_avg;
         double use_lavg = std::isnan(l_avg) ? m : l_avg;
         update_history(g_ticks[i], b, a, use_savg, use_lavg, new_pos, hs, trade_p);
+        short_win.push(m);
+        long_win.push(m);
 
         pos = new_pos;
     }
@@ -299,6 +288,7 @@ double runBacktest(int short_window,
     if(pos != 0 && g_nrows>0){
         double final_bid = g_bids[g_nrows - 1];
         double final_ask = g_asks[g_nrows - 1];
+        record_trade_section(entry_index, g_nrows - 1, entry_mid, 0.5*(final_bid+final_ask), pos);
         if(pos > 0){
             cash += final_bid * pos * (1.0 - FEES);
         } else {
@@ -360,26 +350,64 @@ struct ParamResult {
     double pnl;
 };
 
+// Canonicalize the combo list: sort by parameters and drop repeats.
+// fuzzIntParam rounds several steps to the same int, so without this
+// identical combos get backtested more than once. Each distinct combo
+// is run once and stands for all its duplicates. Returns # dropped.
+size_t dedupCombos(std::vector<ParamResult> &combos)
+{
+    auto key = [](const ParamResult &p){
+        return std::make_tuple(p.short_window, p.waiting_period,
+                               p.hs_exit_change_threshold, p.ma_turn_threshold);
+    };
+    std::sort(combos.begin(), combos.end(),
+              [&](const ParamResult &a, const ParamResult &b){ return key(a) < key(b); });
+    auto last = std::unique(combos.begin(), combos.end(),
+              [&](const ParamResult &a, const ParamResult &b){ return key(a) == key(b); });
+    size_t dropped = (size_t)std::distance(last, combos.end());
+    combos.erase(last, combos.end());
+    return dropped;
+}
+
 //============================================================
 //         MAIN: load CSV, build combos, run in threads
 //============================================================
 #include <mutex>
 #include <condition_variable>
+#include <cstdio>
 #include <atomic>
 #include <chrono>
 #include <iomanip>
+#include <memory>
+#include <cstdint>
 
 // We'll store all combos in a global vector, plus a global 
-// vector for results. We’ll use an atomic index to dispatch.
+// vector for results. A WorkStealingScheduler dispatches index ranges.
 static std::vector<ParamResult> g_combos;
-static std::atomic<size_t> g_nextIdx{0};
 static std::vector<ParamResult> g_results; 
-static std::mutex g_resMutex; // protect g_results updates
+
+// One publication flag per g_results slot: the single worker that owns
+// a slot writes it, then release-stores the flag. Readers take only the
+// slots whose flag they acquire, so nobody ever waits on a lock.
+static std::unique_ptr<std::atomic<uint8_t>[]> g_published;
 
 // We also want to track how many combos have completed
 static std::atomic<size_t> g_doneCount{0};
 static size_t g_totalCount = 0;
 
+// Copy of the slots published so far
+static std::vector<ParamResult> publishedResults()
+{
+    std::vector<ParamResult> out;
+    out.reserve(g_totalCount);
+    for(size_t idx = 0; idx < g_totalCount; idx++){
+        if(g_published[idx].load(std::memory_order_acquire)){
+            out.push_back(g_results[idx]);
+        }
+    }
+    return out;
+}
+
 // For live progress: every second, we’ll print the top 3 combos so far.
 void progressThreadFunc()
 {
@@ -397,11 +425,7 @@ void progressThreadFunc()
         }
 
         // gather top 3
-        std::vector<ParamResult> localCopy;
-        {
-            std::lock_guard<std::mutex> lk(g_resMutex);
-            localCopy = g_results; // copy so we can sort outside the lock
-        }
+        std::vector<ParamResult> localCopy = publishedResults();
         // sort by PnL descending
         std::sort(localCopy.begin(), localCopy.end(),
                   [](auto &a, auto &b){return a.pnl > b.pnl;});
@@ -431,11 +455,7 @@ void progressThreadFunc()
     // Final print after completion
     {
         size_t done = g_doneCount.load();
-        std::vector<ParamResult> localCopy;
-        {
-            std::lock_guard<std::mutex> lk(g_resMutex);
-            localCopy = g_results;
-        }
+        std::vector<ParamResult> localCopy = publishedResults();
         std::sort(localCopy.begin(), localCopy.end(),
                   [](auto &a, auto &b){return a.pnl > b.pnl;});
         
@@ -458,38 +478,58 @@ void progressThreadFunc()
     }
 }
 
-// Worker thread function
-void workerThreadFunc()
+// Worker thread function: runs the ranges the scheduler hands it
+void workerThreadFunc(WorkStealingScheduler &sched, unsigned int worker)
 {
-    while(true){
-        // fetch next index
-        size_t idx = g_nextIdx.fetch_add(1);
-        if(idx >= g_totalCount){
-            // no more
-            return;
-        }
-        // get combo
-        ParamResult pr = g_combos[idx];
+    sched.work(worker, [](size_t begin, size_t end){
+        for(size_t idx = begin; idx < end; idx++){
+            // get combo
+            ParamResult pr = g_combos[idx];
+
+            // run backtest
+            double resultPNL = runBacktest(pr.short_window,
+                                           pr.waiting_period,
+                                           pr.hs_exit_change_threshold,
+                                           pr.ma_turn_threshold);
+            pr.pnl = resultPNL;
 
-        // run backtest
-        double resultPNL = runBacktest(pr.short_window,
-                                       pr.waiting_period,
-                                       pr.hs_exit_change_threshold,
-                                       pr.ma_turn_threshold);
-        pr.pnl = resultPNL;
-
-        {
-            std::lock_guard<std::mutex> lk(g_resMutex);
             g_results[idx] = pr;
-        }
+            g_published[idx].store(1, std::memory_order_release);
 
-        // done
-        g_doneCount.fetch_add(1);
-    }
+            // done
+            g_doneCount.fetch_add(1);
+        }
+    });
 }
 
-int main()
+int main(int argc, char* argv[])
 {
+    // Optional sampling mode instead of the full grid
+    bool sample = false;
+    SampleMethod sampleMethod = SampleMethod::Sobol;
+    uint64_t sampleCount = 4096;
+    uint64_t sampleSeed = 1;
+    int shardIndex = 0, shardCount = 1;
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(arg == "--sample" && i + 1 < argc){
+            if(!ParamSampler::parseMethod(argv[++i], sampleMethod)){
+                std::cerr << "Unknown sampling method " << argv[i] << "\n";
+                return 1;
+            }
+            sample = true;
+        }
+        else if(arg == "--samples" && i + 1 < argc) sampleCount = std::stoull(argv[++i]);
+        else if(arg == "--seed" && i + 1 < argc)    sampleSeed = std::stoull(argv[++i]);
+        else if(arg == "--shard" && i + 1 < argc){
+            if(std::sscanf(argv[++i], "%d/%d", &shardIndex, &shardCount) != 2 ||
+               shardCount < 1 || shardIndex < 0 || shardIndex >= shardCount){
+                std::cerr << "--shard expects i/N with 0 <= i < N\n";
+                return 1;
+            }
+        }
+    }
+
     // 1) Load CSV "UEC.csv"
     {
         std::ifstream fin("UEC.csv");
@@ -542,26 +582,49 @@ int main()
     auto hs_vals = fuzzDoubleParam(base_HS_EXIT_CHANGE);  // hs_exit_change_threshold
     auto ma_vals = fuzzDoubleParam(base_MA_TURN);         // ma_turn_threshold
 
-    // Generate all combos
-    for(int sw : sw_vals){
-        for(int wp : wp_vals){
-            for(double hsx : hs_vals){
-                for(double mat : ma_vals){
-                    ParamResult pr;
-                    pr.short_window            = sw;
-                    pr.waiting_period          = wp;
-                    pr.hs_exit_change_threshold= hsx;
-                    pr.ma_turn_threshold       = mat;
-                    pr.pnl = 0.0;
-                    g_combos.push_back(pr);
+    if(sample){
+        // Points of the same ±10% box; point k depends only on k, so
+        // each --shard runs its own slice of one shared sample
+        ParamSampler sampler({{(double)sw_vals.front(), (double)sw_vals.back(), true},
+                              {(double)wp_vals.front(), (double)wp_vals.back(), true},
+                              {hs_vals.front(), hs_vals.back(), false},
+                              {ma_vals.front(), ma_vals.back(), false}},
+                             sampleMethod, sampleSeed, sampleCount);
+        auto range = ParamSampler::shard(sampleCount, shardIndex, shardCount);
+        for(uint64_t k = range.first; k < range.second; k++){
+            std::vector<double> x = sampler.point(k);
+            g_combos.push_back({(int)x[0], (int)x[1], x[2], x[3], 0.0});
+        }
+        std::cerr << "Sampling points " << range.first << "-" << range.second
+                  << " of " << sampleCount << " (seed " << sampleSeed << ")\n";
+    }
+    else {
+        // Generate all combos
+        for(int sw : sw_vals){
+            for(int wp : wp_vals){
+                for(double hsx : hs_vals){
+                    for(double mat : ma_vals){
+                        ParamResult pr;
+                        pr.short_window            = sw;
+                        pr.waiting_period          = wp;
+                        pr.hs_exit_change_threshold= hsx;
+                        pr.ma_turn_threshold       = mat;
+                        pr.pnl = 0.0;
+                        g_combos.push_back(pr);
+                    }
                 }
             }
         }
     }
+    size_t gridCount = g_combos.size();
+    size_t redundant = dedupCombos(g_combos);
     g_totalCount = g_combos.size();
     g_results.resize(g_totalCount);
+    g_published.reset(new std::atomic<uint8_t>[g_totalCount]());
 
-    std::cerr << "Total combos to test: " << g_totalCount << std::endl;
+    std::cerr << "Total combos to test: " << g_totalCount
+              << " (" << gridCount << (sample ? " sample points, " : " grid points, ")
+              << redundant << " redundant backtests skipped)" << std::endl;
 
     // 3) Spawn threads => as many cores as possible
     unsigned int hw = std::thread::hardware_concurrency();
@@ -572,10 +635,11 @@ int main()
     std::thread progThread(progressThreadFunc);
 
     // Start worker threads
+    WorkStealingScheduler sched(g_totalCount, hw);
     std::vector<std::thread> workers;
     workers.reserve(hw);
     for(unsigned int i=0; i<hw; i++){
-        workers.emplace_back(workerThreadFunc);
+        workers.emplace_back(workerThreadFunc, std::ref(sched), i);
     }
 
     // Join workers
@@ -585,6 +649,7 @@ int main()
 
     // Join progress thread
     progThread.join();
+    sched.report(std::cerr);
 
     // Done
     return 0;
@@ -2,10 +2,53 @@
 #define BACKTESTER_H
 
 #include <vector>
+#include <cstddef>
+
+#include "PreparedDataset.h"
+
+/**
+ * @brief One round-trip trade: entry tick, exit tick, side and profit.
+ *
+ * profit is (exit mid - entry mid) * position for longs and the mirror for
+ * shorts, fees excluded, as in the trace's trade_profit column. A position
+ * still open on the last tick is booked with exit_index = nrows - 1.
+ */
+struct TradeRecord {
+    int    entry_index;
+    int    exit_index;
+    int    side;        // +1 long, -1 short
+    double profit;
+};
+
+/**
+ * @brief Per-tick strategy history recorded by the traced backtest mode.
+ *
+ * All vectors are aligned by tick index. short_avg/long_avg fall back to the
+ * mid price until their windows are full, matching the plotting code.
+ */
+struct BacktestTrace {
+    std::vector<int>    timestamp;
+    std::vector<double> bid;
+    std::vector<double> ask;
+    std::vector<double> mid_price;
+    std::vector<double> spread;
+    std::vector<double> short_avg;
+    std::vector<double> long_avg;
+    std::vector<int>    position;
+    std::vector<bool>   in_high_spread;
+    std::vector<double> trade_profit;
+    std::vector<TradeRecord> trades;
+
+    void clear();
+    void reserve(size_t n);
+};
 
 /**
  * @brief Runs a trading strategy backtest with the given parameters on the provided data.
- * 
+ *
+ * PnL-only mode: keeps just the O(1) state the decisions need and records no
+ * history. After the first call on a thread it performs no heap allocation.
+ *
  * @param short_window Length of the short-term rolling average window
  * @param waiting_period Length of the waiting period after high spread exit
  * @param hs_exit_change_threshold Threshold for re-entry after high spread
@@ -13,11 +56,11 @@
  * @param ticks Vector of timestamps
  * @param bids Vector of bid prices
  * @param asks Vector of ask prices
- * 
+ *
  * @return Final profit and loss (PnL) of the strategy
  */
 double runBacktest(
-    int    short_window, 
+    int    short_window,
     int    waiting_period,
     double hs_exit_change_threshold,
     double ma_turn_threshold,
@@ -26,4 +69,261 @@ double runBacktest(
     const std::vector<double> &asks
 );
 
-#endif // BACKTESTER_H 
\ No newline at end of file
+/**
+ * @brief Traced mode: same strategy as above, additionally recording the
+ * full per-tick history into @p trace (cleared first) for plotting.
+ *
+ * @return Final profit and loss (PnL), identical to the PnL-only mode
+ */
+double runBacktest(
+    int    short_window,
+    int    waiting_period,
+    double hs_exit_change_threshold,
+    double ma_turn_threshold,
+    const std::vector<int>    &ticks,
+    const std::vector<double> &bids,
+    const std::vector<double> &asks,
+    BacktestTrace             &trace
+);
+
+/**
+ * @brief PnL-only mode that also returns the closed trades in @p trades
+ * (cleared first). Entry state is tracked explicitly, so each exit is O(1).
+ *
+ * @return Final profit and loss (PnL), identical to the other modes
+ */
+double runBacktest(
+    int    short_window,
+    int    waiting_period,
+    double hs_exit_change_threshold,
+    double ma_turn_threshold,
+    const std::vector<int>    &ticks,
+    const std::vector<double> &bids,
+    const std::vector<double> &asks,
+    std::vector<TradeRecord>  &trades
+);
+
+/**
+ * @brief PnL-only mode over a PreparedDataset built once after loading.
+ *
+ * Reads the precomputed mid/spread/high-spread columns and takes the short
+ * average from the mid prefix sums, so each tick is a handful of loads.
+ * Windows covered by fixedBacktestKernel() run the matching
+ * runBacktestFixed<SW> instance; any other window runs runBacktestGeneric().
+ *
+ * @return Final profit and loss (PnL)
+ */
+double runBacktest(
+    int    short_window,
+    int    waiting_period,
+    double hs_exit_change_threshold,
+    double ma_turn_threshold,
+    const PreparedDataset     &data
+);
+
+/**
+ * @brief PreparedDataset mode with the order size as a parameter instead of
+ * the built-in 100. The high-spread threshold is the one @p data was
+ * prepared with. Orders that would take the position past ±100 are still
+ * dropped, so sizes above 100 never trade.
+ *
+ * @return Final profit and loss (PnL)
+ */
+double runBacktest(
+    int    short_window,
+    int    waiting_period,
+    double hs_exit_change_threshold,
+    double ma_turn_threshold,
+    int    position_size,
+    const PreparedDataset     &data
+);
+
+/**
+ * @brief Structural switches of the strategy, beyond its four thresholds.
+ *
+ * The defaults are the strategy every other overload runs.
+ */
+struct StrategyVariant {
+    // Keep a position open through a high spread instead of closing on its
+    // first tick; it closes once the short average moves against it. A
+    // spread that ends with the position still held arms no new entry:
+    // the next one waits for the next high-spread exit.
+    bool hold_during_high_spread = false;
+
+    // Entries allowed: 0 both sides, +1 long only, -1 short only. A signal
+    // for the other side is consumed without trading.
+    int  entry_sides = 0;
+};
+
+/**
+ * @brief PreparedDataset mode running a StrategyVariant. With a
+ * default-constructed variant the PnL equals the plain overload's.
+ *
+ * @return Final profit and loss (PnL)
+ */
+double runBacktest(
+    int    short_window,
+    int    waiting_period,
+    double hs_exit_change_threshold,
+    double ma_turn_threshold,
+    const StrategyVariant     &variant,
+    const PreparedDataset     &data
+);
+
+/**
+ * @brief The PreparedDataset kernel with a runtime short window, bypassing
+ * the fixed-window dispatch table. Identical results for every window.
+ *
+ * @return Final profit and loss (PnL)
+ */
+double runBacktestGeneric(
+    int    short_window,
+    int    waiting_period,
+    double hs_exit_change_threshold,
+    double ma_turn_threshold,
+    const PreparedDataset     &data
+);
+
+/**
+ * @brief Event-driven PnL-only mode over a PreparedDataset.
+ *
+ * While flat and not waiting to re-enter, nothing can happen before the next
+ * high-spread exit, so the kernel jumps there via PreparedDataset::hs_exits.
+ * While waiting, it also jumps past the waiting period and across
+ * high-spread runs. Ticks are only stepped one by one while a position is
+ * open or an entry is possible. Results are identical to runBacktest().
+ *
+ * @return Final profit and loss (PnL)
+ */
+double runBacktestEvents(
+    int    short_window,
+    int    waiting_period,
+    double hs_exit_change_threshold,
+    double ma_turn_threshold,
+    const PreparedDataset     &data
+);
+
+/**
+ * @brief Short windows with a compile-time specialized kernel. Covers the
+ * ±10% fuzz range around 80 (72-88) and try3's range (68-92).
+ */
+constexpr int FIXED_WINDOW_MIN = 68;
+constexpr int FIXED_WINDOW_MAX = 92;
+
+/**
+ * @brief PreparedDataset kernel with the short window fixed at compile time,
+ * so the window lag and divisor are constants. Instantiated for every
+ * window in [FIXED_WINDOW_MIN, FIXED_WINDOW_MAX].
+ *
+ * @return Final profit and loss (PnL), identical to runBacktestGeneric()
+ */
+template <int SW>
+double runBacktestFixed(
+    int    waiting_period,
+    double hs_exit_change_threshold,
+    double ma_turn_threshold,
+    const PreparedDataset     &data
+);
+
+using FixedBacktestFn = double (*)(int, double, double, const PreparedDataset &);
+
+/**
+ * @brief Looks up the runBacktestFixed<SW> instance for @p short_window.
+ *
+ * @return The specialized kernel, or nullptr if the window is out of range
+ */
+FixedBacktestFn fixedBacktestKernel(int short_window);
+
+/**
+ * @brief Number of parameter sets a ParamBlock can hold.
+ */
+constexpr int PARAM_BLOCK_SIZE = 64;
+
+/**
+ * @brief Structure-of-arrays block of parameter sets for runBacktestBatch().
+ */
+struct ParamBlock {
+    int    count = 0;
+    int    short_window[PARAM_BLOCK_SIZE];
+    int    waiting_period[PARAM_BLOCK_SIZE];
+    double hs_exit_change_threshold[PARAM_BLOCK_SIZE];
+    double ma_turn_threshold[PARAM_BLOCK_SIZE];
+
+    void clear() { count = 0; }
+    bool full() const { return count == PARAM_BLOCK_SIZE; }
+
+    // Appends one parameter set; the caller checks full() first
+    void add(int sw, int wp, double hsx, double mat)
+    {
+        short_window[count]             = sw;
+        waiting_period[count]           = wp;
+        hs_exit_change_threshold[count] = hsx;
+        ma_turn_threshold[count]        = mat;
+        count++;
+    }
+};
+
+/**
+ * @brief Runs every parameter set in @p block in one pass over the data.
+ *
+ * All sets advance together tick by tick, so each tick's columns are loaded
+ * once per block instead of once per parameter set. Results are identical
+ * to calling the PreparedDataset runBacktest() overload for each set.
+ *
+ * @param block Parameter sets to evaluate (block.count of them)
+ * @param data Precomputed dataset
+ * @param pnlOut Receives block.count final PnLs, in block order
+ * @param short_avg Optional short-average series from
+ *        PreparedDataset::windowMeans(), shared by every set in the block;
+ *        all sets must then have that series' short_window
+ */
+void runBacktestBatch(
+    const ParamBlock      &block,
+    const PreparedDataset &data,
+    double                *pnlOut,
+    const double          *short_avg = nullptr
+);
+
+/**
+ * @brief Instruction sets runBacktestSimd() can run on.
+ */
+enum class SimdLevel {
+    Scalar = 0,  // runBacktestBatch()
+    AVX2   = 1,  // 4 parameter sets per register
+    AVX512 = 2   // 8 parameter sets per register
+};
+
+/**
+ * @brief Widest SimdLevel supported by this CPU (detected once at runtime).
+ */
+SimdLevel bestSimdLevel();
+
+/**
+ * @brief Short lowercase name of @p level ("scalar", "avx2", "avx512").
+ */
+const char *simdLevelName(SimdLevel level);
+
+/**
+ * @brief Vectorized runBacktestBatch(): each SIMD lane runs one parameter set.
+ *
+ * The strategy's branches become per-lane masks and blends; the tick data is
+ * broadcast to every lane. PnL is bit-identical to the scalar kernels. A
+ * level the CPU lacks falls back to the widest supported one, and
+ * SimdLevel::Scalar (or a non-x86 build) runs runBacktestBatch().
+ *
+ * @param block Parameter sets to evaluate (block.count of them)
+ * @param data Precomputed dataset
+ * @param pnlOut Receives block.count final PnLs, in block order
+ * @param level Instruction set to use, normally bestSimdLevel()
+ * @param short_avg Optional shared short-average series, as for
+ *        runBacktestBatch(); replaces the per-lane window lookups
+ */
+void runBacktestSimd(
+    const ParamBlock      &block,
+    const PreparedDataset &data,
+    double                *pnlOut,
+    SimdLevel              level,
+    const double          *short_avg = nullptr
+);
+
+#endif // BACKTESTER_H
\ No newline at end of file
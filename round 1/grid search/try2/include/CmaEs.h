@@ -0,0 +1,200 @@
+#ifndef CMA_ES_H
+#define CMA_ES_H
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <numeric>
+#include <algorithm>
+
+/**
+ * @brief Covariance Matrix Adaptation Evolution Strategy, maximizing.
+ *
+ * Standard (mu/mu_w, lambda)-CMA-ES with cumulative step-size adaptation,
+ * rank-one and rank-mu covariance updates (Hansen, "The CMA Evolution
+ * Strategy: A Tutorial"). Use it ask/tell style: ask() returns a whole
+ * generation, the caller evaluates it however it likes (e.g. as one batch
+ * on the worker threads) and hands the scores back to tell().
+ *
+ * The search is continuous. Integer parameters are rounded by the caller
+ * when evaluating, while the distribution keeps the unrounded points.
+ */
+class CmaEs {
+public:
+    CmaEs(const std::vector<double> &mean, double sigma, int lambda, uint64_t seed)
+        : n_((int)mean.size()), lambda_(lambda), mean_(mean), sigma_(sigma), rng_(seed)
+    {
+        mu_ = lambda_ / 2;
+        for (int i = 0; i < mu_; i++) {
+            weights_.push_back(std::log(mu_ + 0.5) - std::log(i + 1.0));
+        }
+        double sum = std::accumulate(weights_.begin(), weights_.end(), 0.0);
+        double sumSq = 0.0;
+        for (double &w : weights_) {
+            w /= sum;
+            sumSq += w * w;
+        }
+        mueff_ = 1.0 / sumSq;
+
+        double n = n_;
+        cc_    = (4.0 + mueff_ / n) / (n + 4.0 + 2.0 * mueff_ / n);
+        cs_    = (mueff_ + 2.0) / (n + mueff_ + 5.0);
+        c1_    = 2.0 / ((n + 1.3) * (n + 1.3) + mueff_);
+        cmu_   = std::min(1.0 - c1_, 2.0 * (mueff_ - 2.0 + 1.0 / mueff_) / ((n + 2.0) * (n + 2.0) + mueff_));
+        damps_ = 1.0 + 2.0 * std::max(0.0, std::sqrt((mueff_ - 1.0) / (n + 1.0)) - 1.0) + cs_;
+        chiN_  = std::sqrt(n) * (1.0 - 1.0 / (4.0 * n) + 1.0 / (21.0 * n * n));
+
+        pc_.assign(n_, 0.0);
+        ps_.assign(n_, 0.0);
+        C_.assign(n_ * n_, 0.0);
+        B_.assign(n_ * n_, 0.0);
+        D_.assign(n_, 1.0);
+        for (int i = 0; i < n_; i++) {
+            C_[i * n_ + i] = 1.0;
+            B_[i * n_ + i] = 1.0;
+        }
+    }
+
+    // Draws the next generation: lambda points m + sigma * B * D * z
+    std::vector<std::vector<double>> ask()
+    {
+        std::normal_distribution<double> normal(0.0, 1.0);
+        std::vector<std::vector<double>> xs(lambda_, std::vector<double>(n_));
+        for (auto &x : xs) {
+            std::vector<double> z(n_);
+            for (double &v : z) v = normal(rng_);
+            for (int i = 0; i < n_; i++) {
+                double y = 0.0;
+                for (int j = 0; j < n_; j++) y += B_[i * n_ + j] * D_[j] * z[j];
+                x[i] = mean_[i] + sigma_ * y;
+            }
+        }
+        return xs;
+    }
+
+    // Updates the distribution from one generation's scores (higher = better)
+    void tell(const std::vector<std::vector<double>> &xs, const std::vector<double> &scores)
+    {
+        std::vector<int> order(xs.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](int a, int b){ return scores[a] > scores[b]; });
+
+        std::vector<double> old = mean_;
+        std::fill(mean_.begin(), mean_.end(), 0.0);
+        for (int k = 0; k < mu_; k++) {
+            for (int i = 0; i < n_; i++) mean_[i] += weights_[k] * xs[order[k]][i];
+        }
+        std::vector<double> step(n_);
+        for (int i = 0; i < n_; i++) step[i] = (mean_[i] - old[i]) / sigma_;
+
+        // Step-size path uses C^-1/2 * step = B * D^-1 * B^T * step
+        std::vector<double> bt(n_, 0.0), cInvHalf(n_, 0.0);
+        for (int j = 0; j < n_; j++) {
+            for (int i = 0; i < n_; i++) bt[j] += B_[i * n_ + j] * step[i];
+            bt[j] /= D_[j];
+        }
+        for (int i = 0; i < n_; i++) {
+            for (int j = 0; j < n_; j++) cInvHalf[i] += B_[i * n_ + j] * bt[j];
+        }
+        double csNorm = std::sqrt(cs_ * (2.0 - cs_) * mueff_);
+        double psLen = 0.0;
+        for (int i = 0; i < n_; i++) {
+            ps_[i] = (1.0 - cs_) * ps_[i] + csNorm * cInvHalf[i];
+            psLen += ps_[i] * ps_[i];
+        }
+        psLen = std::sqrt(psLen);
+        generation_++;
+        bool hsig = psLen / std::sqrt(1.0 - std::pow(1.0 - cs_, 2.0 * generation_)) / chiN_
+                    < 1.4 + 2.0 / (n_ + 1.0);
+
+        double ccNorm = std::sqrt(cc_ * (2.0 - cc_) * mueff_);
+        for (int i = 0; i < n_; i++) {
+            pc_[i] = (1.0 - cc_) * pc_[i] + (hsig ? ccNorm * step[i] : 0.0);
+        }
+
+        // Rank-one and rank-mu covariance update
+        double keep = 1.0 - c1_ - cmu_ + (hsig ? 0.0 : c1_ * cc_ * (2.0 - cc_));
+        for (int i = 0; i < n_; i++) {
+            for (int j = 0; j <= i; j++) {
+                double rankMu = 0.0;
+                for (int k = 0; k < mu_; k++) {
+                    const std::vector<double> &x = xs[order[k]];
+                    rankMu += weights_[k] * (x[i] - old[i]) * (x[j] - old[j]);
+                }
+                double c = keep * C_[i * n_ + j] + c1_ * pc_[i] * pc_[j]
+                         + cmu_ * rankMu / (sigma_ * sigma_);
+                C_[i * n_ + j] = C_[j * n_ + i] = c;
+            }
+        }
+
+        sigma_ *= std::exp((cs_ / damps_) * (psLen / chiN_ - 1.0));
+        decompose();
+    }
+
+    const std::vector<double> &mean() const { return mean_; }
+    double sigma() const { return sigma_; }
+    int    generation() const { return generation_; }
+
+    // Largest standard deviation along any axis of the distribution
+    double spread() const { return sigma_ * *std::max_element(D_.begin(), D_.end()); }
+
+private:
+    // C = B * diag(D^2) * B^T by cyclic Jacobi rotations (n is tiny)
+    void decompose()
+    {
+        std::vector<double> a = C_;
+        std::fill(B_.begin(), B_.end(), 0.0);
+        for (int i = 0; i < n_; i++) B_[i * n_ + i] = 1.0;
+
+        for (int sweep = 0; sweep < 50; sweep++) {
+            double off = 0.0;
+            for (int p = 0; p < n_; p++)
+                for (int q = p + 1; q < n_; q++) off += a[p * n_ + q] * a[p * n_ + q];
+            if (off < 1e-30) break;
+
+            for (int p = 0; p < n_; p++) {
+                for (int q = p + 1; q < n_; q++) {
+                    double apq = a[p * n_ + q];
+                    if (std::fabs(apq) < 1e-300) continue;
+                    double theta = (a[q * n_ + q] - a[p * n_ + p]) / (2.0 * apq);
+                    double t = (theta >= 0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+                    double c = 1.0 / std::sqrt(t * t + 1.0), s = t * c;
+                    for (int k = 0; k < n_; k++) {
+                        double akp = a[k * n_ + p], akq = a[k * n_ + q];
+                        a[k * n_ + p] = c * akp - s * akq;
+                        a[k * n_ + q] = s * akp + c * akq;
+                    }
+                    for (int k = 0; k < n_; k++) {
+                        double apk = a[p * n_ + k], aqk = a[q * n_ + k];
+                        a[p * n_ + k] = c * apk - s * aqk;
+                        a[q * n_ + k] = s * apk + c * aqk;
+                    }
+                    for (int k = 0; k < n_; k++) {
+                        double bkp = B_[k * n_ + p], bkq = B_[k * n_ + q];
+                        B_[k * n_ + p] = c * bkp - s * bkq;
+                        B_[k * n_ + q] = s * bkp + c * bkq;
+                    }
+                }
+            }
+        }
+        for (int i = 0; i < n_; i++) {
+            D_[i] = std::sqrt(std::max(a[i * n_ + i], 1e-20));
+        }
+    }
+
+    int    n_;
+    int    lambda_;
+    int    mu_;
+    std::vector<double> weights_;
+    double mueff_, cc_, cs_, c1_, cmu_, damps_, chiN_;
+
+    std::vector<double> mean_;
+    double              sigma_;
+    std::vector<double> pc_, ps_;
+    std::vector<double> C_, B_, D_;   // row-major n x n, D = sqrt(eigenvalues)
+    int                 generation_ = 0;
+    std::mt19937_64     rng_;
+};
+
+#endif // CMA_ES_H
@@ -0,0 +1,85 @@
+#ifndef GRID_FILTER_H
+#define GRID_FILTER_H
+
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <cstddef>
+
+/**
+ * @brief Neighbourhood statistics over a dense row-major tensor of results,
+ * e.g. the fuzzer's PnL grid indexed by (SW, WP, HSX, MAT) step.
+ *
+ * Both filters cover the box of ±k steps along every axis, clipped at the
+ * grid edges. The box is a product of per-axis intervals, so its mean and
+ * its minimum can each be taken one axis at a time: one sliding-window pass
+ * per axis instead of a (2k+1)^N loop per point. A pass is O(size) for any
+ * k; the mean uses running sums over each line, the minimum a monotonic
+ * deque. For the mean the clipped count factors per axis as well, so
+ * dividing in every pass gives the exact mean over the clipped box.
+ */
+class GridFilter {
+public:
+    // Mean over each point's ±k box
+    static std::vector<double> boxMean(std::vector<double> t, const std::vector<int> &dims, int k)
+    {
+        std::vector<double> line, sums;
+        for (size_t axis = 0; axis < dims.size(); axis++) {
+            forEachLine(t, dims, axis, [&](int n, auto at) {
+                sums.assign(n + 1, 0.0);
+                for (int i = 0; i < n; i++) sums[i + 1] = sums[i] + at(i);
+                line.resize(n);
+                for (int i = 0; i < n; i++) {
+                    int lo = std::max(0, i - k), hi = std::min(n, i + k + 1);
+                    line[i] = (sums[hi] - sums[lo]) / (hi - lo);
+                }
+                for (int i = 0; i < n; i++) at(i) = line[i];
+            });
+        }
+        return t;
+    }
+
+    // Minimum over each point's ±k box
+    static std::vector<double> boxMin(std::vector<double> t, const std::vector<int> &dims, int k)
+    {
+        std::vector<double> line;
+        std::deque<int> window;   // indices with increasing values
+        for (size_t axis = 0; axis < dims.size(); axis++) {
+            forEachLine(t, dims, axis, [&](int n, auto at) {
+                line.resize(n);
+                window.clear();
+                int next = 0;
+                for (int i = 0; i < n; i++) {
+                    for (; next < std::min(n, i + k + 1); next++) {
+                        while (!window.empty() && at(window.back()) >= at(next)) window.pop_back();
+                        window.push_back(next);
+                    }
+                    while (window.front() < i - k) window.pop_front();
+                    line[i] = at(window.front());
+                }
+                for (int i = 0; i < n; i++) at(i) = line[i];
+            });
+        }
+        return t;
+    }
+
+private:
+    // Calls fn(n, at) for every line of the tensor along axis, where at(i)
+    // is a reference to the line's i-th element
+    template <typename Fn>
+    static void forEachLine(std::vector<double> &t, const std::vector<int> &dims, size_t axis, Fn fn)
+    {
+        size_t stride = 1;
+        for (size_t d = axis + 1; d < dims.size(); d++) stride *= (size_t)dims[d];
+        size_t n     = (size_t)dims[axis];
+        size_t outer = t.size() / (n * stride);
+        for (size_t o = 0; o < outer; o++) {
+            for (size_t s = 0; s < stride; s++) {
+                double *base = t.data() + o * n * stride + s;
+                fn((int)n, [base, stride](int i) -> double & { return base[i * stride]; });
+            }
+        }
+    }
+};
+
+#endif // GRID_FILTER_H
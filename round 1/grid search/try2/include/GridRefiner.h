@@ -0,0 +1,294 @@
+#ifndef GRID_REFINER_H
+#define GRID_REFINER_H
+
+#include <array>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <cstdlib>
+#include <ostream>
+
+/**
+ * @brief One parameter set of the UEC strategy and its backtest PnL.
+ */
+struct RefinePoint {
+    int    short_window;
+    int    waiting_period;
+    double hs_exit_change_threshold;
+    double ma_turn_threshold;
+    double pnl;
+};
+
+/**
+ * @brief Tuning knobs for GridRefiner.
+ *
+ * Offsets are whole percentages of each base parameter, so step 1 is the
+ * dense grid's 1% spacing.
+ */
+struct RefineConfig {
+    int range      = 32;  // search ±range% around the base
+    int coarseStep = 8;   // first lattice spacing (%), halved each level
+    int keepBest   = 8;   // cells refined around the highest PnLs
+    int keepStable = 8;   // cells refined around the best neighbourhood means
+    int maxPolish  = 8;   // extra 1% rounds while the best keeps improving
+};
+
+/**
+ * @brief Coarse-to-fine search over the 4-parameter percentage lattice.
+ *
+ * Level 0 evaluates the whole lattice at coarseStep over ±range. Each later
+ * level halves the step and evaluates the new lattice points within one old
+ * step of the selected cells only: the keepBest points with the highest PnL
+ * plus the keepStable points whose mean PnL over themselves and their
+ * evaluated axis neighbours is highest (so a lone spike cannot draw all of
+ * the refinement). Once at 1%, it polishes for up to maxPolish rounds,
+ * each evaluating the ±1% neighbourhoods of the best points not expanded
+ * yet, and stops early when a round does not improve the best PnL.
+ *
+ * Points are memoized by their concrete parameters, so offsets that round
+ * to the same integer window are only backtested once. Evaluation is
+ * delegated to a batch callback, which can spread each level over threads.
+ */
+class GridRefiner {
+public:
+    using Offsets   = std::array<int, 4>;
+    using ToPoint   = std::function<RefinePoint(const Offsets &)>;
+    using BatchEval = std::function<void(std::vector<RefinePoint> &)>;
+
+    GridRefiner(const RefineConfig &cfg, ToPoint toPoint)
+        : cfg_(cfg), toPoint_(std::move(toPoint)) {}
+
+    // Runs every level; returns the best point found
+    RefinePoint run(const BatchEval &eval, std::ostream *log = nullptr)
+    {
+        int step = std::max(1, cfg_.coarseStep);
+        int span = (std::max(0, cfg_.range) / step) * step;
+
+        // Level 0: full coarse lattice
+        std::vector<Offsets> pending;
+        forEachOffset(Offsets{0, 0, 0, 0}, span / step, step, pending);
+        evaluate(pending, eval);
+        report(log, step);
+
+        while (step > 1) {
+            std::vector<Offsets> centers = selectCenters(step);
+            int next = std::max(1, step / 2);
+            pending.clear();
+            for (const Offsets &c : centers) {
+                forEachOffset(c, step / next, next, pending);
+            }
+            step = next;
+            evaluate(pending, eval);
+            report(log, step);
+        }
+
+        // Polish at 1%: expand the best points whose neighbourhoods are
+        // still unexplored, until a round no longer improves the best
+        for (int round = 0; round < cfg_.maxPolish; round++) {
+            double before = best(std::numeric_limits<int>::max()).pnl;
+            pending.clear();
+            for (const Offsets &c : unexpandedBest(cfg_.keepBest + cfg_.keepStable)) {
+                forEachOffset(c, 1, 1, pending);
+                expanded_.push_back(c);
+            }
+            if (pending.empty()) {
+                break;
+            }
+            evaluate(pending, eval);
+            report(log, 1);
+            if (best(std::numeric_limits<int>::max()).pnl <= before) {
+                break;
+            }
+        }
+        return best(std::numeric_limits<int>::max());
+    }
+
+    // Best evaluated point with every offset within ±span%
+    RefinePoint best(int span) const
+    {
+        RefinePoint out{0, 0, 0.0, 0.0, -std::numeric_limits<double>::infinity()};
+        for (const auto &kv : byOffset_) {
+            bool inside = true;
+            for (int d = 0; d < 4; d++) {
+                inside = inside && std::abs(kv.first[d]) <= span;
+            }
+            if (inside && kv.second.pnl > out.pnl) {
+                out = kv.second;
+            }
+        }
+        return out;
+    }
+
+    // Distinct parameter sets backtested so far
+    size_t evaluations() const { return byParams_.size(); }
+
+private:
+    using ParamKey = std::tuple<int, int, double, double>;
+
+    static ParamKey key(const RefinePoint &p)
+    {
+        return ParamKey(p.short_window, p.waiting_period,
+                        p.hs_exit_change_threshold, p.ma_turn_threshold);
+    }
+
+    // Appends center + step * (d0..d3) for every d in [-radius, radius]^4
+    // that lies inside ±range
+    void forEachOffset(const Offsets &center, int radius, int step,
+                       std::vector<Offsets> &out) const
+    {
+        Offsets o;
+        for (int a = -radius; a <= radius; a++)
+        for (int b = -radius; b <= radius; b++)
+        for (int c = -radius; c <= radius; c++)
+        for (int d = -radius; d <= radius; d++) {
+            o = {center[0] + a * step, center[1] + b * step,
+                 center[2] + c * step, center[3] + d * step};
+            bool inside = true;
+            for (int k = 0; k < 4; k++) {
+                inside = inside && std::abs(o[k]) <= cfg_.range;
+            }
+            if (inside) {
+                out.push_back(o);
+            }
+        }
+    }
+
+    // Backtests the offsets not seen before, one batch per level
+    void evaluate(const std::vector<Offsets> &offsets, const BatchEval &eval)
+    {
+        std::vector<RefinePoint> batch;
+        std::vector<Offsets>     waiting;
+        std::map<ParamKey, size_t> inBatch;
+        for (const Offsets &o : offsets) {
+            if (byOffset_.count(o)) {
+                continue;
+            }
+            RefinePoint p = toPoint_(o);
+            auto known = byParams_.find(key(p));
+            if (known != byParams_.end()) {
+                p.pnl = known->second;
+                byOffset_[o] = p;
+                continue;
+            }
+            if (!inBatch.count(key(p))) {
+                inBatch[key(p)] = batch.size();
+                batch.push_back(p);
+            }
+            waiting.push_back(o);
+        }
+
+        if (!batch.empty()) {
+            eval(batch);
+        }
+        for (const RefinePoint &p : batch) {
+            byParams_[key(p)] = p.pnl;
+        }
+        for (const Offsets &o : waiting) {
+            RefinePoint p = toPoint_(o);
+            p.pnl = byParams_[key(p)];
+            byOffset_[o] = p;
+        }
+    }
+
+    // Mean PnL of o and its evaluated axis neighbours at this step
+    double stability(const Offsets &o, double pnl, int step) const
+    {
+        double sum = pnl;
+        int    n   = 1;
+        for (int d = 0; d < 4; d++) {
+            for (int s : {-step, step}) {
+                Offsets nb = o;
+                nb[d] += s;
+                auto it = byOffset_.find(nb);
+                if (it != byOffset_.end()) {
+                    sum += it->second.pnl;
+                    n++;
+                }
+            }
+        }
+        return sum / n;
+    }
+
+    // Top cells of the current lattice by PnL and by neighbourhood mean
+    std::vector<Offsets> selectCenters(int step) const
+    {
+        std::vector<std::pair<double, Offsets>> byPnl, byMean;
+        for (const auto &kv : byOffset_) {
+            bool onLattice = true;
+            for (int d = 0; d < 4; d++) {
+                onLattice = onLattice && kv.first[d] % step == 0;
+            }
+            if (!onLattice) {
+                continue;
+            }
+            byPnl.push_back({kv.second.pnl, kv.first});
+            byMean.push_back({stability(kv.first, kv.second.pnl, step), kv.first});
+        }
+
+        // Highest score first, ties broken by offsets for determinism
+        auto higher = [](const std::pair<double, Offsets> &a,
+                         const std::pair<double, Offsets> &b) {
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+        };
+        std::sort(byPnl.begin(), byPnl.end(), higher);
+        std::sort(byMean.begin(), byMean.end(), higher);
+
+        std::vector<Offsets> centers;
+        auto take = [&](const std::vector<std::pair<double, Offsets>> &ranked, int n) {
+            for (int i = 0; i < (int)ranked.size() && n > 0; i++) {
+                if (std::find(centers.begin(), centers.end(), ranked[i].second) == centers.end()) {
+                    centers.push_back(ranked[i].second);
+                    n--;
+                }
+            }
+        };
+        take(byPnl, cfg_.keepBest);
+        take(byMean, cfg_.keepStable);
+        return centers;
+    }
+
+    // The n highest-PnL points not yet used as a polish center
+    std::vector<Offsets> unexpandedBest(int n) const
+    {
+        std::vector<std::pair<double, Offsets>> ranked;
+        for (const auto &kv : byOffset_) {
+            if (std::find(expanded_.begin(), expanded_.end(), kv.first) == expanded_.end()) {
+                ranked.push_back({kv.second.pnl, kv.first});
+            }
+        }
+        int keep = std::min(n, (int)ranked.size());
+        std::partial_sort(ranked.begin(), ranked.begin() + keep, ranked.end(),
+                          [](const std::pair<double, Offsets> &a,
+                             const std::pair<double, Offsets> &b) {
+                              return a.first != b.first ? a.first > b.first : a.second < b.second;
+                          });
+        std::vector<Offsets> out;
+        for (int i = 0; i < keep; i++) {
+            out.push_back(ranked[i].second);
+        }
+        return out;
+    }
+
+    void report(std::ostream *log, int step) const
+    {
+        if (!log) {
+            return;
+        }
+        RefinePoint b = best(std::numeric_limits<int>::max());
+        *log << "  step " << step << "%: " << evaluations() << " backtests so far, best PnL "
+             << b.pnl << " [SW=" << b.short_window << ", WP=" << b.waiting_period
+             << ", HSX=" << b.hs_exit_change_threshold << ", MAT=" << b.ma_turn_threshold
+             << "]\n";
+    }
+
+    RefineConfig                cfg_;
+    ToPoint                     toPoint_;
+    std::map<Offsets, RefinePoint> byOffset_;
+    std::map<ParamKey, double>  byParams_;
+    std::vector<Offsets>        expanded_;
+};
+
+#endif // GRID_REFINER_H
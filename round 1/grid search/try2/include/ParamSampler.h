@@ -0,0 +1,214 @@
+#ifndef PARAM_SAMPLER_H
+#define PARAM_SAMPLER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+
+/**
+ * @brief Bounds of one sampled parameter. Integer dimensions draw every
+ * value in [lo, hi] with equal probability; lo == hi pins a parameter.
+ */
+struct SampleDim {
+    double lo;
+    double hi;
+    bool   integer;
+};
+
+enum class SampleMethod {
+    Sobol,          // Owen-scrambled Sobol sequence, up to MAX_DIMS dimensions
+    LatinHypercube  // one point per stratum of every dimension, jittered
+};
+
+/**
+ * @brief Fixed-budget low-discrepancy sample over box bounds, as a
+ * replacement for nested grid loops whose size grows exponentially with
+ * the number of parameters.
+ *
+ * point(k) is a pure function of (dims, method, seed, n, k), so any thread
+ * or process can generate any index range on its own and the union of the
+ * shards is exactly the full sample. shard() gives the usual split.
+ *
+ * Sobol points use Joe-Kuo direction numbers with a per-dimension hashed
+ * nested uniform scramble (Burley 2020); use a power-of-two n for the best
+ * balance. The Latin hypercube keeps one seeded stratum permutation per
+ * dimension (n ints each).
+ */
+class ParamSampler {
+public:
+    static constexpr int MAX_DIMS = 16;
+
+    ParamSampler(std::vector<SampleDim> dims, SampleMethod method, uint64_t seed, uint64_t n)
+        : dims_(std::move(dims)), method_(method), seed_(seed), n_(n)
+    {
+        if (dims_.size() > (size_t)MAX_DIMS) {
+            throw std::invalid_argument("ParamSampler: too many dimensions");
+        }
+        for (size_t d = 0; d < dims_.size(); d++) {
+            scramble_.push_back((uint32_t)mix(seed_ + 0x9e3779b97f4a7c15ull * (d + 1)));
+        }
+        if (method_ == SampleMethod::Sobol) {
+            for (size_t d = 0; d < dims_.size(); d++) {
+                directions_.push_back(sobolDirections((int)d));
+            }
+        } else {
+            // Seeded Fisher-Yates per dimension; splitmix64 rather than a
+            // std:: distribution so every platform draws the same sample
+            for (size_t d = 0; d < dims_.size(); d++) {
+                std::vector<uint32_t> perm(n_);
+                for (uint64_t k = 0; k < n_; k++) perm[k] = (uint32_t)k;
+                uint64_t state = seed_ ^ (0xd1b54a32d192ed03ull * (d + 1));
+                for (uint64_t k = n_; k > 1; k--) {
+                    uint64_t j = next(state) % k;
+                    std::swap(perm[k - 1], perm[j]);
+                }
+                strata_.push_back(std::move(perm));
+            }
+        }
+    }
+
+    uint64_t size() const { return n_; }
+    size_t   dims() const { return dims_.size(); }
+
+    // Point k (0 <= k < size()) in parameter units
+    std::vector<double> point(uint64_t k) const
+    {
+        std::vector<double> x(dims_.size());
+        for (size_t d = 0; d < dims_.size(); d++) {
+            x[d] = scale(dims_[d], unit(k, d));
+        }
+        return x;
+    }
+
+    // [begin, end) indices of shard i out of count
+    static std::pair<uint64_t, uint64_t> shard(uint64_t n, int i, int count)
+    {
+        return {n * (uint64_t)i / (uint64_t)count, n * (uint64_t)(i + 1) / (uint64_t)count};
+    }
+
+    // Parses "sobol" / "lhs"; returns false for anything else
+    static bool parseMethod(const std::string &name, SampleMethod &out)
+    {
+        if (name == "sobol") { out = SampleMethod::Sobol;          return true; }
+        if (name == "lhs")   { out = SampleMethod::LatinHypercube; return true; }
+        return false;
+    }
+
+private:
+    // Coordinate d of point k in [0, 1)
+    double unit(uint64_t k, size_t d) const
+    {
+        if (method_ == SampleMethod::Sobol) {
+            uint32_t x = 0;
+            const std::vector<uint32_t> &v = directions_[d];
+            for (int j = 0; j < 32 && (k >> j); j++) {
+                if ((k >> j) & 1) x ^= v[j];
+            }
+            return (nestedScramble(x, scramble_[d]) + 0.5) * (1.0 / 4294967296.0);
+        }
+        uint64_t h = mix(seed_ ^ mix(k * MAX_DIMS + d + 1));
+        double jitter = (h >> 11) * (1.0 / 9007199254740992.0);
+        return (strata_[d][k] + jitter) / (double)n_;
+    }
+
+    static double scale(const SampleDim &dim, double u)
+    {
+        if (dim.integer) {
+            double v = std::floor(dim.lo + u * (dim.hi - dim.lo + 1.0));
+            return v > dim.hi ? dim.hi : v;
+        }
+        return dim.lo + u * (dim.hi - dim.lo);
+    }
+
+    // Direction numbers v[j] = m_j / 2^(j+1) as 32-bit fractions for
+    // dimension d, from primitive polynomial (degree s, coefficients a)
+    // and initial m values (Joe & Kuo, new-joe-kuo-6.21201)
+    static std::vector<uint32_t> sobolDirections(int d)
+    {
+        struct Poly { int s; unsigned a; unsigned m[6]; };
+        static const Poly table[MAX_DIMS - 1] = {
+            {1, 0,  {1}},
+            {2, 1,  {1, 3}},
+            {3, 1,  {1, 3, 1}},
+            {3, 2,  {1, 1, 1}},
+            {4, 1,  {1, 1, 3, 3}},
+            {4, 4,  {1, 3, 5, 13}},
+            {5, 2,  {1, 1, 5, 5, 17}},
+            {5, 4,  {1, 1, 5, 5, 5}},
+            {5, 7,  {1, 1, 7, 11, 19}},
+            {5, 11, {1, 1, 5, 1, 1}},
+            {5, 13, {1, 1, 1, 3, 11}},
+            {5, 14, {1, 3, 5, 5, 31}},
+            {6, 1,  {1, 3, 3, 9, 7, 49}},
+            {6, 13, {1, 1, 1, 15, 21, 21}},
+            {6, 16, {1, 3, 1, 13, 27, 49}},
+        };
+
+        std::vector<uint32_t> v(32);
+        if (d == 0) {
+            for (int j = 0; j < 32; j++) v[j] = 1u << (31 - j);
+            return v;
+        }
+        const Poly &p = table[d - 1];
+        for (int j = 0; j < 32; j++) {
+            if (j < p.s) {
+                v[j] = p.m[j] << (31 - j);
+                continue;
+            }
+            v[j] = v[j - p.s] ^ (v[j - p.s] >> p.s);
+            for (int k = 1; k < p.s; k++) {
+                if ((p.a >> (p.s - 1 - k)) & 1) v[j] ^= v[j - k];
+            }
+        }
+        return v;
+    }
+
+    // Hash-based Owen scramble: flips each bit depending on all higher
+    // bits, so the (t, s)-net structure survives
+    static uint32_t nestedScramble(uint32_t x, uint32_t seed)
+    {
+        x = reverseBits(x);
+        x += seed;
+        x ^= x * 0x6c50b47cu;
+        x ^= x * 0xb82f1e52u;
+        x ^= x * 0xc7afe638u;
+        x ^= x * 0x8d22f6e6u;
+        return reverseBits(x);
+    }
+
+    static uint32_t reverseBits(uint32_t x)
+    {
+        x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+        x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+        x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+        x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+        return (x >> 16) | (x << 16);
+    }
+
+    // splitmix64 finalizer and step
+    static uint64_t mix(uint64_t z)
+    {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+    static uint64_t next(uint64_t &state)
+    {
+        state += 0x9e3779b97f4a7c15ull;
+        return mix(state);
+    }
+
+    std::vector<SampleDim>             dims_;
+    SampleMethod                       method_;
+    uint64_t                           seed_;
+    uint64_t                           n_;
+    std::vector<uint32_t>              scramble_;
+    std::vector<std::vector<uint32_t>> directions_;
+    std::vector<std::vector<uint32_t>> strata_;
+};
+
+#endif // PARAM_SAMPLER_H
@@ -0,0 +1,147 @@
+#ifndef PARTIAL_RESULTS_H
+#define PARTIAL_RESULTS_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief One backtested parameter set as stored in a partial-results file.
+ */
+struct PartialRecord {
+    int32_t short_window;
+    int32_t waiting_period;
+    double  hs_exit_change_threshold;
+    double  ma_turn_threshold;
+    double  pnl;
+};
+
+/**
+ * @brief Which sweep a partial-results file belongs to and which slice of it
+ * the file holds.
+ *
+ * sweep describes everything that defines the combo space (mode, bounds,
+ * sample seed, data file), so files can only be merged when it is identical.
+ */
+struct PartialHeader {
+    std::string sweep;
+    uint32_t    shard_index = 0;
+    uint32_t    shard_count = 1;
+    uint64_t    total       = 0;  // combos in the whole sweep, all shards together
+};
+
+/**
+ * @brief Binary results of one fuzzer shard, for merging with fuzz-merge.
+ *
+ * Layout (little-endian hosts only, like the rest of the tools):
+ *   "FZPART01", sweep length u32, sweep bytes, shard index u32,
+ *   shard count u32, total u64, record count u64, then per record
+ *   short_window i32, waiting_period i32, hsx f64, mat f64, pnl f64.
+ * Fields are written one by one, so struct padding never reaches the file.
+ */
+class PartialResults {
+public:
+    static bool write(const std::string &path, const PartialHeader &header,
+                      const std::vector<PartialRecord> &records)
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        out.write(MAGIC, 8);
+        put(out, (uint32_t)header.sweep.size());
+        out.write(header.sweep.data(), (std::streamsize)header.sweep.size());
+        put(out, header.shard_index);
+        put(out, header.shard_count);
+        put(out, header.total);
+        put(out, (uint64_t)records.size());
+        for (const PartialRecord &r : records) {
+            put(out, r.short_window);
+            put(out, r.waiting_period);
+            put(out, r.hs_exit_change_threshold);
+            put(out, r.ma_turn_threshold);
+            put(out, r.pnl);
+        }
+        return (bool)out;
+    }
+
+    // Reads a whole file; on failure returns false and says why in error
+    static bool read(const std::string &path, PartialHeader &header,
+                     std::vector<PartialRecord> &records, std::string &error)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            error = "cannot open";
+            return false;
+        }
+        char magic[8];
+        in.read(magic, 8);
+        if (!in || std::memcmp(magic, MAGIC, 8) != 0) {
+            error = "not a fuzzer partial-results file";
+            return false;
+        }
+        uint32_t sweepLen = 0;
+        uint64_t count = 0;
+        get(in, sweepLen);
+        if (!in || sweepLen > (1u << 20)) {
+            error = "damaged header";
+            return false;
+        }
+        header.sweep.assign(sweepLen, '\0');
+        in.read(&header.sweep[0], sweepLen);
+        get(in, header.shard_index);
+        get(in, header.shard_count);
+        get(in, header.total);
+        get(in, count);
+        if (!in || header.shard_count == 0 || header.shard_index >= header.shard_count) {
+            error = "damaged header";
+            return false;
+        }
+
+        // count comes from the file: check it against the sweep size and the
+        // bytes left before trusting it with an allocation
+        std::streampos here = in.tellg();
+        in.seekg(0, std::ios::end);
+        uint64_t left = (uint64_t)(in.tellg() - here);
+        in.seekg(here);
+        if (!in || count > header.total) {
+            error = "damaged header";
+            return false;
+        }
+        if (count > left / RECORD_BYTES) {
+            error = "truncated after " + std::to_string(left / RECORD_BYTES) + " of " + std::to_string(count) + " records";
+            return false;
+        }
+
+        records.clear();
+        records.reserve((size_t)count);
+        for (uint64_t k = 0; k < count; k++) {
+            PartialRecord r;
+            get(in, r.short_window);
+            get(in, r.waiting_period);
+            get(in, r.hs_exit_change_threshold);
+            get(in, r.ma_turn_threshold);
+            get(in, r.pnl);
+            if (!in) {
+                error = "truncated after " + std::to_string(k) + " of " + std::to_string(count) + " records";
+                return false;
+            }
+            records.push_back(r);
+        }
+        return true;
+    }
+
+private:
+    static constexpr const char *MAGIC = "FZPART01";
+    static constexpr uint64_t RECORD_BYTES = 2 * sizeof(int32_t) + 3 * sizeof(double);
+
+    template <typename T>
+    static void put(std::ofstream &out, T v) { out.write(reinterpret_cast<const char *>(&v), sizeof(T)); }
+
+    template <typename T>
+    static void get(std::ifstream &in, T &v) { in.read(reinterpret_cast<char *>(&v), sizeof(T)); }
+};
+
+#endif // PARTIAL_RESULTS_H
@@ -0,0 +1,113 @@
+#ifndef PREPARED_DATASET_H
+#define PREPARED_DATASET_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+
+/**
+ * @brief Minimal allocator giving cache-line (64 byte) aligned storage.
+ */
+template <typename T>
+struct AlignedAllocator {
+    using value_type = T;
+    static constexpr std::size_t ALIGNMENT = 64;
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U> &) {}
+
+    T *allocate(std::size_t n)
+    {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(ALIGNMENT)));
+    }
+    void deallocate(T *p, std::size_t)
+    {
+        ::operator delete(p, std::align_val_t(ALIGNMENT));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U> &) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U> &) const { return false; }
+};
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+/**
+ * @brief Parameter-independent columns derived once from the raw CSV data.
+ *
+ * Built once after loading and then shared read-only by every backtest, so
+ * workers no longer recompute mid, spread and the high-spread flag per combo.
+ * Columns are structure-of-arrays and 64-byte aligned.
+ *
+ *   mid[i]        0.5 * (bid + ask)
+ *   spread[i]     ask - bid
+ *   hs_mask       bit i set when spread[i] >= the high-spread threshold
+ *   mid_prefix[k] sum of mid[0 .. k-1] (size n + 1)
+ *   hs_entries    ticks where a high-spread run starts (ascending)
+ *   hs_exits      first tick after each high-spread run (ascending)
+ *
+ * With the prefix sums, the mean of any window is two loads and a subtract.
+ * The high-spread event index lets the event-driven kernel jump straight
+ * from one run boundary to the next.
+ */
+struct PreparedDataset {
+    std::vector<int>        ticks;
+    AlignedVector<double>   bid;
+    AlignedVector<double>   ask;
+    AlignedVector<double>   mid;
+    AlignedVector<double>   spread;
+    AlignedVector<uint64_t> hs_mask;
+    AlignedVector<double>   mid_prefix;
+    std::vector<int>        hs_entries;
+    std::vector<int>        hs_exits;
+    double                  hs_threshold = 0.0;
+
+    PreparedDataset() = default;
+    PreparedDataset(const std::vector<int>    &ticks,
+                    const std::vector<double> &bids,
+                    const std::vector<double> &asks);
+
+    // Same columns, flagging high spread at spread >= hs_threshold instead
+    // of the strategy's built-in threshold
+    PreparedDataset(const std::vector<int>    &ticks,
+                    const std::vector<double> &bids,
+                    const std::vector<double> &asks,
+                    double                     hs_threshold);
+
+    int size() const { return (int)mid.size(); }
+
+    bool highSpread(int i) const
+    {
+        return (hs_mask[i >> 6] >> (i & 63)) & 1u;
+    }
+
+    // Sum of the n mid prices before tick `end` (mid[end-n .. end-1])
+    double windowSum(int end, int n) const
+    {
+        return mid_prefix[end] - mid_prefix[end - n];
+    }
+
+    // Mean of the n mid prices before tick `end`, NaN if fewer exist
+    double windowMean(int end, int n) const
+    {
+        if (n < 1 || end < n) {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        return windowSum(end, n) / n;
+    }
+
+    // Materializes windowMean(i, n) for every tick i into out[0 .. size()-1]
+    void windowMeans(int n, double *out) const
+    {
+        for (int i = 0; i < size(); i++) {
+            out[i] = windowMean(i, n);
+        }
+    }
+};
+
+#endif // PREPARED_DATASET_H
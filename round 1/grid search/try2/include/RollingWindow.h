@@ -0,0 +1,101 @@
+#ifndef ROLLING_WINDOW_H
+#define ROLLING_WINDOW_H
+
+#include <vector>
+#include <limits>
+
+/**
+ * @brief Streaming mean over the last N samples of a series.
+ *
+ * Samples live in a ring buffer alongside their running sum, so push() and
+ * mean() are O(1) regardless of the window length. Each time the ring wraps
+ * the sum is rebuilt from the buffer in oldest-to-newest order, which bounds
+ * round-off drift to a single revolution and reproduces the naive
+ * left-to-right sum exactly at every wrap point.
+ *
+ * reset() keeps the allocated capacity, so one instance can be reused across
+ * backtests without touching the heap again.
+ */
+class RollingWindow {
+public:
+    RollingWindow() = default;
+    explicit RollingWindow(int window) { reset(window); }
+
+    // Clear all samples and set a new window length
+    void reset(int window)
+    {
+        window_ = window > 0 ? window : 0;
+        if ((int)buf_.size() < window_) {
+            buf_.resize(window_);
+        }
+        count_ = 0;
+        head_  = 0;
+        sum_   = 0.0;
+    }
+
+    // Append a sample, evicting the oldest one once the window is full
+    void push(double x)
+    {
+        if (window_ == 0) {
+            return;
+        }
+        if (count_ < window_) {
+            count_++;
+        } else {
+            sum_ -= buf_[head_];
+        }
+        buf_[head_] = x;
+        sum_ += x;
+
+        if (++head_ == window_) {
+            head_ = 0;
+            if (count_ == window_) {
+                double s = 0.0;
+                for (int i = 0; i < window_; i++) {
+                    s += buf_[i];
+                }
+                sum_ = s;
+            }
+        }
+    }
+
+    // Rebuild the exact state reached after pushing series[0 .. pushed-1],
+    // given sum() at that point. The ring contents and head follow from the
+    // series alone, so a checkpoint only needs (pushed, sum()).
+    void restore(int window, const double *series, long pushed, double sum)
+    {
+        reset(window);
+        if (window_ == 0 || pushed <= 0) {
+            return;
+        }
+        count_ = pushed < window_ ? (int)pushed : window_;
+        head_  = (int)(pushed % window_);
+        for (long j = pushed - count_; j < pushed; j++) {
+            buf_[j % window_] = series[j];
+        }
+        sum_ = sum;
+    }
+
+    bool   full()   const { return window_ > 0 && count_ == window_; }
+    int    size()   const { return count_; }
+    int    window() const { return window_; }
+    double sum()    const { return sum_; }
+
+    // Mean of the window, or NaN until N samples have been pushed
+    double mean() const
+    {
+        if (!full()) {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        return sum_ / window_;
+    }
+
+private:
+    std::vector<double> buf_;
+    int    window_ = 0;
+    int    count_  = 0;
+    int    head_   = 0;
+    double sum_    = 0.0;
+};
+
+#endif // ROLLING_WINDOW_H
@@ -0,0 +1,286 @@
+#ifndef SWEEP_PROTOCOL_H
+#define SWEEP_PROTOCOL_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/**
+ * @brief Messages between a sweep coordinator and its worker processes.
+ *
+ * Each frame is a u32 type, a u32 payload length and the payload. Every
+ * field is little-endian on the wire whatever the host, so a coordinator
+ * and workers on different boxes agree. Payloads:
+ *   Hello  (worker -> coordinator): magic u32, data fingerprint u64, threads u32
+ *   Lease  (coordinator -> worker): lease id u64, count u32,
+ *                                   count x {sw i32, wp i32, hsx f64, mat f64}
+ *   Result (worker -> coordinator): lease id u64, count u32, count x pnl f64
+ *   Done   (coordinator -> worker): empty, the sweep is finished
+ *   Reject (coordinator -> worker): reason text
+ */
+enum class SweepMsg : uint32_t {
+    Hello  = 1,
+    Lease  = 2,
+    Result = 3,
+    Done   = 4,
+    Reject = 5
+};
+
+constexpr uint32_t SWEEP_PROTOCOL_MAGIC = 0x315a5546;  // "FUZ1"
+constexpr uint32_t SWEEP_MAX_PAYLOAD    = 64u << 20;
+
+// Same-size unsigned integer of a 4- or 8-byte field, for byte order
+template <typename T>
+using SweepBits = typename std::conditional<sizeof(T) == 8, uint64_t, uint32_t>::type;
+
+// Writes v to out[0..sizeof(T)) least significant byte first
+template <typename T>
+inline void sweepEncode(T v, char *out)
+{
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8, "wire fields are 4 or 8 bytes");
+    SweepBits<T> bits;
+    std::memcpy(&bits, &v, sizeof(T));
+    for (size_t i = 0; i < sizeof(T); i++) {
+        out[i] = (char)(bits >> (8 * i));
+    }
+}
+
+// Reads a field written by sweepEncode()
+template <typename T>
+inline T sweepDecode(const char *in)
+{
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8, "wire fields are 4 or 8 bytes");
+    SweepBits<T> bits = 0;
+    for (size_t i = 0; i < sizeof(T); i++) {
+        bits |= (SweepBits<T>)(unsigned char)in[i] << (8 * i);
+    }
+    T v;
+    std::memcpy(&v, &bits, sizeof(T));
+    return v;
+}
+
+/**
+ * @brief Appends fixed-size fields to a payload.
+ */
+class SweepWriter {
+public:
+    template <typename T>
+    SweepWriter &put(T v)
+    {
+        char field[sizeof(T)];
+        sweepEncode(v, field);
+        bytes_.append(field, sizeof(T));
+        return *this;
+    }
+    const std::string &bytes() const { return bytes_; }
+
+private:
+    std::string bytes_;
+};
+
+/**
+ * @brief Reads fixed-size fields back; ok() turns false on a short payload.
+ */
+class SweepReader {
+public:
+    explicit SweepReader(const std::string &bytes) : bytes_(bytes) {}
+
+    template <typename T>
+    T get()
+    {
+        if (pos_ + sizeof(T) > bytes_.size()) {
+            ok_ = false;
+            return T{};
+        }
+        T v = sweepDecode<T>(bytes_.data() + pos_);
+        pos_ += sizeof(T);
+        return v;
+    }
+    bool ok() const { return ok_; }
+
+private:
+    const std::string &bytes_;
+    size_t pos_ = 0;
+    bool   ok_  = true;
+};
+
+/**
+ * @brief One framed connection. Owns the socket and closes it.
+ *
+ * send() and receive() block. A poll() loop instead calls fill() when the
+ * socket is readable and then drains next(), so one slow or dead peer never
+ * holds up the others.
+ */
+class SweepChannel {
+public:
+    explicit SweepChannel(int fd) : fd_(fd) {}
+    ~SweepChannel() { if (fd_ >= 0) ::close(fd_); }
+    SweepChannel(const SweepChannel &) = delete;
+    SweepChannel &operator=(const SweepChannel &) = delete;
+
+    int  fd() const { return fd_; }
+    bool broken() const { return broken_; }
+
+    // False if the peer is gone
+    bool send(SweepMsg type, const std::string &payload = std::string())
+    {
+        char head[8];
+        sweepEncode((uint32_t)type, head);
+        sweepEncode((uint32_t)payload.size(), head + 4);
+        return writeAll(head, sizeof(head)) && writeAll(payload.data(), payload.size());
+    }
+
+    // Blocks for the next whole message; false on EOF or error
+    bool receive(SweepMsg &type, std::string &payload)
+    {
+        while (!next(type, payload)) {
+            if (!readSome()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Buffers whatever is readable now; false on EOF, error or a bad frame
+    bool fill()
+    {
+        int flags = ::fcntl(fd_, F_GETFL, 0);
+        ::fcntl(fd_, F_SETFL, flags | O_NONBLOCK);
+        bool alive = readSome();
+        ::fcntl(fd_, F_SETFL, flags);
+        return alive && !broken_;
+    }
+
+    // Pops one buffered message, if a whole one has arrived
+    bool next(SweepMsg &type, std::string &payload)
+    {
+        if (buf_.size() < 8) {
+            return false;
+        }
+        uint32_t head[2] = {sweepDecode<uint32_t>(buf_.data()),
+                            sweepDecode<uint32_t>(buf_.data() + 4)};
+        if (head[1] > SWEEP_MAX_PAYLOAD) {
+            broken_ = true;
+            return false;
+        }
+        if (buf_.size() < 8 + (size_t)head[1]) {
+            return false;
+        }
+        type = (SweepMsg)head[0];
+        payload.assign(buf_, 8, head[1]);
+        buf_.erase(0, 8 + (size_t)head[1]);
+        return true;
+    }
+
+private:
+    bool writeAll(const void *data, size_t n)
+    {
+        const char *p = static_cast<const char *>(data);
+        while (n > 0) {
+            ssize_t k = ::send(fd_, p, n, MSG_NOSIGNAL);
+            if (k <= 0) {
+                return false;
+            }
+            p += k;
+            n -= (size_t)k;
+        }
+        return true;
+    }
+
+    // One read into the buffer; EAGAIN on a non-blocking socket is not an error
+    bool readSome()
+    {
+        char chunk[65536];
+        ssize_t k = ::read(fd_, chunk, sizeof(chunk));
+        if (k > 0) {
+            buf_.append(chunk, (size_t)k);
+            return true;
+        }
+        return k < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+    }
+
+    int         fd_;
+    std::string buf_;
+    bool        broken_ = false;
+};
+
+/**
+ * @brief Opens a stream socket for @p addr, listening or connecting.
+ *
+ * Addresses are "unix:PATH", "tcp:HOST:PORT", or a bare path (Unix
+ * socket). A listening Unix socket replaces any stale file at PATH.
+ *
+ * @return The socket, or -1 with @p error set
+ */
+inline int sweepSocket(const std::string &addr, bool listen, std::string &error)
+{
+    if (addr.compare(0, 4, "tcp:") == 0) {
+        size_t colon = addr.rfind(':');
+        std::string host = addr.substr(4, colon - 4);
+        std::string port = addr.substr(colon + 1);
+        if (colon <= 4 || port.empty()) {
+            error = "expected tcp:HOST:PORT";
+            return -1;
+        }
+        addrinfo hints{}, *res = nullptr;
+        hints.ai_family   = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        if (::getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0 || !res) {
+            error = "cannot resolve " + host;
+            return -1;
+        }
+        int fd = ::socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+        int one = 1;
+        bool ok = fd >= 0;
+        if (ok && listen) {
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            ok = ::bind(fd, res->ai_addr, res->ai_addrlen) == 0 && ::listen(fd, 64) == 0;
+        }
+        else if (ok) {
+            ok = ::connect(fd, res->ai_addr, res->ai_addrlen) == 0;
+        }
+        ::freeaddrinfo(res);
+        if (!ok) {
+            error = std::string(listen ? "cannot listen on " : "cannot connect to ") + addr
+                    + ": " + std::strerror(errno);
+            if (fd >= 0) ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    std::string path = addr.compare(0, 5, "unix:") == 0 ? addr.substr(5) : addr;
+    sockaddr_un sa{};
+    if (path.empty() || path.size() >= sizeof(sa.sun_path)) {
+        error = "bad Unix socket path " + path;
+        return -1;
+    }
+    sa.sun_family = AF_UNIX;
+    std::strncpy(sa.sun_path, path.c_str(), sizeof(sa.sun_path) - 1);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    bool ok = fd >= 0;
+    if (ok && listen) {
+        ::unlink(path.c_str());
+        ok = ::bind(fd, (sockaddr *)&sa, sizeof(sa)) == 0 && ::listen(fd, 64) == 0;
+    }
+    else if (ok) {
+        ok = ::connect(fd, (sockaddr *)&sa, sizeof(sa)) == 0;
+    }
+    if (!ok) {
+        error = std::string(listen ? "cannot listen on " : "cannot connect to ") + path
+                + ": " + std::strerror(errno);
+        if (fd >= 0) ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+#endif // SWEEP_PROTOCOL_H
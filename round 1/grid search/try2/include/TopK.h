@@ -0,0 +1,121 @@
+#ifndef TOP_K_H
+#define TOP_K_H
+
+#include <vector>
+#include <mutex>
+#include <algorithm>
+#include <functional>
+#include <cstddef>
+
+/**
+ * @brief The K largest values offered so far under `Less`.
+ *
+ * Kept as a min-heap, so the worst kept value is at the front and a value
+ * that does not make the cut is rejected with one comparison. Offering is
+ * O(log K) when the value is kept and O(1) otherwise; nothing is rebuilt.
+ */
+template <typename T, std::size_t K, typename Less = std::less<T>>
+class TopK {
+public:
+    /**
+     * @brief Keeps v if it beats the worst kept value (or K is not reached).
+     * @return true when v was kept
+     */
+    bool offer(const T &v)
+    {
+        if (heap_.size() < K) {
+            heap_.push_back(v);
+            std::push_heap(heap_.begin(), heap_.end(), worse);
+            return true;
+        }
+        if (!Less()(heap_.front(), v)) return false;
+        std::pop_heap(heap_.begin(), heap_.end(), worse);
+        heap_.back() = v;
+        std::push_heap(heap_.begin(), heap_.end(), worse);
+        return true;
+    }
+
+    /** @brief Offers every value kept by other. */
+    void merge(const TopK &other)
+    {
+        for (const T &v : other.heap_) offer(v);
+    }
+
+    /** @brief Kept values in heap order (unsorted). */
+    const std::vector<T> &items() const { return heap_; }
+
+    /** @brief Kept values, best first. */
+    std::vector<T> sorted() const
+    {
+        std::vector<T> out = heap_;
+        std::sort(out.begin(), out.end(), [](const T &a, const T &b){ return Less()(b, a); });
+        return out;
+    }
+
+    std::size_t size() const { return heap_.size(); }
+    bool empty() const { return heap_.empty(); }
+
+private:
+    // Heap comparator that puts the smallest value at the front
+    static bool worse(const T &a, const T &b) { return Less()(b, a); }
+
+    std::vector<T> heap_;
+};
+
+/**
+ * @brief One worker thread's TopK, plus a copy a progress thread can read.
+ *
+ * The owning worker offers every result to its private TopK without any
+ * lock. Only when a value is kept, which becomes rare once the heap holds
+ * good results, does it refresh the shared copy under a mutex that no other
+ * worker touches, so workers never wait on each other and only the progress
+ * thread's snapshot() can briefly hold them up. After the workers are
+ * joined, result() is read directly. Aligned so neighbouring workers'
+ * entries do not share a cache line.
+ */
+template <typename T, std::size_t K, typename Less = std::less<T>>
+class alignas(64) WorkerTopK {
+public:
+    /** @brief Called by the owning worker only. */
+    void offer(const T &v)
+    {
+        if (!own_.offer(v)) return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        shown_ = own_.items();
+    }
+
+    /** @brief Copy of the kept values as of the owner's last change. */
+    std::vector<T> snapshot() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return shown_;
+    }
+
+    /** @brief The owner's TopK; only valid once the owner has finished. */
+    const TopK<T, K, Less> &result() const { return own_; }
+
+private:
+    TopK<T, K, Less> own_;
+    mutable std::mutex mutex_;
+    std::vector<T> shown_;
+};
+
+/**
+ * @brief Best n values across every worker's latest snapshot and the values
+ *        already in `all`, best first.
+ *
+ * Costs O(workers * K) however many results the workers have seen.
+ */
+template <typename T, std::size_t K, typename Less>
+std::vector<T> mergeSnapshots(const std::vector<WorkerTopK<T, K, Less>> &workers, std::size_t n,
+                              TopK<T, K, Less> all = {})
+{
+    for (const auto &w : workers) {
+        for (const T &v : w.snapshot()) all.offer(v);
+    }
+    std::vector<T> out = all.sorted();
+    if (out.size() > n) out.resize(n);
+    return out;
+}
+
+#endif // TOP_K_H
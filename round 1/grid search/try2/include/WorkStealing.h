@@ -0,0 +1,233 @@
+#ifndef WORK_STEALING_H
+#define WORK_STEALING_H
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <ostream>
+#include <iomanip>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Hands out [begin, end) index ranges of a fixed workload to a fixed
+ *        set of worker threads, with per-worker deques and stealing.
+ *
+ * The workload [0, total) starts split into one contiguous range per
+ * worker. A worker claims chunks from the front of its own deque, sized
+ * to take about targetSeconds at its measured cost per item, so cheap
+ * items go out in large chunks and expensive ones (short windows, busy
+ * parameter sets) in small ones. A chunk never takes more than half of
+ * the worker's remaining items, which leaves something to steal near the
+ * end. Once its own deque is empty a worker steals the back half of the
+ * last range of whichever worker has the most items left.
+ *
+ * Each deque has its own mutex: the owner takes it once per chunk and a
+ * thief only while splitting a range, so workers do not share one hot
+ * counter. Chunk boundaries stay multiples of grain (apart from total),
+ * so batched kernels keep full blocks.
+ *
+ * work() also records per-worker busy time, chunks and steals, which
+ * report() prints as utilization once the workers are joined.
+ */
+class WorkStealingScheduler {
+public:
+    struct Options {
+        std::size_t grain         = 1;       // chunk boundaries are multiples of this
+        std::size_t maxChunk      = 1 << 16; // items per chunk at most
+        double      targetSeconds = 0.02;    // wanted run time of one chunk
+    };
+
+    struct WorkerStats {
+        std::size_t items  = 0;
+        std::size_t chunks = 0;
+        std::size_t steals = 0;
+        double      busy   = 0.0; // seconds inside work()'s callback
+        double      active = 0.0; // seconds from construction until out of work
+    };
+
+    WorkStealingScheduler(std::size_t total, unsigned int workers)
+        : WorkStealingScheduler(total, workers, Options()) {}
+
+    WorkStealingScheduler(std::size_t total, unsigned int workers, Options opts)
+        : opts_(opts), workers_(new Worker[std::max(1u, workers)]),
+          count_(std::max(1u, workers)), started_(Clock::now())
+    {
+        if (opts_.grain == 0) opts_.grain = 1;
+        opts_.maxChunk = std::max(opts_.maxChunk, opts_.grain);
+        std::size_t blocks = (total + opts_.grain - 1) / opts_.grain;
+        for (unsigned int w = 0; w < count_; w++) {
+            std::size_t b = std::min(total, blocks * w / count_ * opts_.grain);
+            std::size_t e = std::min(total, blocks * (w + 1) / count_ * opts_.grain);
+            if (b < e) {
+                workers_[w].ranges.push_back({b, e});
+                workers_[w].remaining = e - b;
+            }
+        }
+    }
+
+    unsigned int workers() const { return count_; }
+
+    /**
+     * @brief Claims the next range for worker w.
+     * @return false once no worker has anything left to hand out
+     */
+    bool next(unsigned int w, std::size_t &begin, std::size_t &end)
+    {
+        Worker &self = workers_[w];
+        if (takeOwn(self, begin, end)) return true;
+
+        // Steal until a split succeeds or every deque is empty
+        while (true) {
+            unsigned int victim = count_;
+            std::size_t most = 0;
+            for (unsigned int k = 1; k < count_; k++) {
+                unsigned int v = (w + k) % count_;
+                std::size_t left = workers_[v].remaining.load(std::memory_order_relaxed);
+                if (left > most) {
+                    most = left;
+                    victim = v;
+                }
+            }
+            if (victim == count_) {
+                self.stats.active = seconds();
+                return false;
+            }
+
+            Range stolen{0, 0};
+            {
+                Worker &v = workers_[victim];
+                std::lock_guard<std::mutex> lock(v.mutex);
+                if (v.ranges.empty()) continue;
+                Range &back = v.ranges.back();
+                std::size_t half = (back.end - back.begin) / 2;
+                std::size_t split = back.begin + (half + opts_.grain - 1) / opts_.grain * opts_.grain;
+                if (half == 0 || split >= back.end) {
+                    stolen = back;
+                    v.ranges.pop_back();
+                } else {
+                    stolen = {split, back.end};
+                    back.end = split;
+                }
+                v.remaining -= stolen.end - stolen.begin;
+            }
+            {
+                std::lock_guard<std::mutex> lock(self.mutex);
+                self.ranges.push_back(stolen);
+                self.remaining += stolen.end - stolen.begin;
+            }
+            self.stats.steals++;
+            if (takeOwn(self, begin, end)) return true;
+        }
+    }
+
+    /**
+     * @brief Runs fn(begin, end) on worker w's ranges until all work is
+     *        claimed, timing each call to size the next chunk.
+     */
+    template <typename Fn>
+    void work(unsigned int w, Fn &&fn)
+    {
+        Worker &self = workers_[w];
+        std::size_t begin, end;
+        while (next(w, begin, end)) {
+            auto t0 = Clock::now();
+            fn(begin, end);
+            double dt = std::chrono::duration<double>(Clock::now() - t0).count();
+
+            double perItem = dt / (end - begin);
+            self.secPerItem = self.secPerItem > 0.0 ? 0.7 * self.secPerItem + 0.3 * perItem : perItem;
+            self.stats.items += end - begin;
+            self.stats.chunks++;
+            self.stats.busy += dt;
+        }
+    }
+
+    /** @brief Worker w's counters; only valid once w has finished. */
+    const WorkerStats &stats(unsigned int w) const { return workers_[w].stats; }
+
+    /**
+     * @brief Prints one line per worker: items, chunks, steals and busy time
+     *        as a share of the run's wall time (first worker start to last
+     *        worker out of work). Call after the workers are joined.
+     */
+    void report(std::ostream &os) const
+    {
+        double wall = 0.0, busy = 0.0;
+        for (unsigned int w = 0; w < count_; w++) {
+            wall = std::max(wall, workers_[w].stats.active);
+            busy += workers_[w].stats.busy;
+        }
+        if (wall <= 0.0) return;
+
+        std::ios::fmtflags flags = os.flags();
+        std::streamsize precision = os.precision();
+        os << "Thread utilization over " << std::fixed << std::setprecision(1) << wall << " s:\n";
+        for (unsigned int w = 0; w < count_; w++) {
+            const WorkerStats &s = workers_[w].stats;
+            os << "  thread " << std::setw(2) << w << ": "
+               << std::setw(9) << s.items << " items, "
+               << std::setw(6) << s.chunks << " chunks, "
+               << std::setw(4) << s.steals << " steals, busy "
+               << std::setprecision(1) << std::setw(5) << 100.0 * s.busy / wall << "%\n";
+        }
+        os << "  mean busy " << std::setprecision(1) << 100.0 * busy / (wall * count_) << "%\n";
+        os.flags(flags);
+        os.precision(precision);
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Range {
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    struct alignas(64) Worker {
+        std::mutex               mutex;
+        std::deque<Range>        ranges;
+        std::atomic<std::size_t> remaining{0}; // items in ranges, for picking victims
+        double                   secPerItem = 0.0; // owner only
+        WorkerStats              stats;            // owner only
+    };
+
+    // Claims a chunk from the front of self's deque
+    bool takeOwn(Worker &self, std::size_t &begin, std::size_t &end)
+    {
+        std::lock_guard<std::mutex> lock(self.mutex);
+        if (self.ranges.empty()) return false;
+
+        std::size_t want = opts_.grain;
+        if (self.secPerItem > 0.0) {
+            double items = opts_.targetSeconds / self.secPerItem;
+            want = items >= (double)opts_.maxChunk ? opts_.maxChunk : (std::size_t)items;
+        }
+        want = std::min(want, self.remaining.load(std::memory_order_relaxed) / 2);
+        want = std::max(opts_.grain, std::min(want, opts_.maxChunk) / opts_.grain * opts_.grain);
+
+        Range &front = self.ranges.front();
+        begin = front.begin;
+        end = std::min(front.end, front.begin + want);
+        front.begin = end;
+        if (front.begin == front.end) self.ranges.pop_front();
+        self.remaining -= end - begin;
+        return true;
+    }
+
+    double seconds() const
+    {
+        return std::chrono::duration<double>(Clock::now() - started_).count();
+    }
+
+    Options                   opts_;
+    std::unique_ptr<Worker[]> workers_;
+    unsigned int              count_;
+    Clock::time_point         started_;
+};
+
+#endif // WORK_STEALING_H
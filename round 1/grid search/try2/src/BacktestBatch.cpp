@@ -0,0 +1,66 @@
+#include "../include/Backtester.h"
+#include "../include/PreparedDataset.h"
+#include "Strategy.h"
+#include <limits>
+
+// ---------------------------------------------------------
+// runBacktestBatch(): advances a whole ParamBlock per tick
+//   The tick columns (bid, ask, mid, hs bit, mid_prefix[i]) are
+//   loaded once and shared by every lane; only the lagged prefix
+//   load mid_prefix[i - short_window] is per lane, and it falls in
+//   the few cache lines just behind i. Lane states stay in L1.
+//   With a shared short_avg series there is no per-lane load.
+// ---------------------------------------------------------
+void runBacktestBatch(
+    const ParamBlock      &block,
+    const PreparedDataset &data,
+    double                *pnlOut,
+    const double          *short_avg
+)
+{
+    const int count = block.count;
+    const int nrows = data.size();
+    if(nrows == 0) {
+        for(int k = 0; k < count; k++) {
+            pnlOut[k] = 0.0;
+        }
+        return;
+    }
+
+    StrategyParams params[PARAM_BLOCK_SIZE];
+    StrategyState  states[PARAM_BLOCK_SIZE];
+    for(int k = 0; k < count; k++) {
+        params[k] = {block.short_window[k], block.waiting_period[k],
+                     block.hs_exit_change_threshold[k], block.ma_turn_threshold[k]};
+    }
+
+    const double *prefix = data.mid_prefix.data();
+    const double  NaN    = std::numeric_limits<double>::quiet_NaN();
+
+    for(int i = 0; i < nrows; i++) {
+        double b   = data.bid[i];
+        double a   = data.ask[i];
+        double m   = data.mid[i];
+        bool   hs  = data.highSpread(i);
+        double p_i = prefix[i];
+
+        if(short_avg) {
+            double s_avg = short_avg[i];
+            for(int k = 0; k < count; k++) {
+                strategyStep(states[k], params[k], i, b, a, m, hs, s_avg, nullptr);
+            }
+            continue;
+        }
+        for(int k = 0; k < count; k++) {
+            // Same expression as PreparedDataset::windowMean()
+            int sw = params[k].short_window;
+            double s_avg = (sw >= 1 && i >= sw) ? (p_i - prefix[i - sw]) / sw : NaN;
+            strategyStep(states[k], params[k], i, b, a, m, hs, s_avg, nullptr);
+        }
+    }
+
+    for(int k = 0; k < count; k++) {
+        flattenPosition(states[k], nrows - 1, data.bid[nrows - 1], data.ask[nrows - 1], nullptr);
+        pnlOut[k] = states[k].cash;
+    }
+}
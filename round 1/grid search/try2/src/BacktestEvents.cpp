@@ -0,0 +1,67 @@
+#include "../include/Backtester.h"
+#include "../include/PreparedDataset.h"
+#include "Strategy.h"
+#include <algorithm>
+
+// ---------------------------------------------------------
+// runBacktestEvents(): event-driven UEC simulation
+//   The strategy can only act on a tick when it holds a position
+//   (cases 0 and 3), when an entry is possible (case 2: waiting,
+//   flat, out of high spread, waiting period elapsed, short
+//   average valid), or on a high-spread exit (case 1). Every other
+//   tick is a no-op, so the kernel jumps over them and steps the
+//   rest through strategyStep() exactly as the tick-by-tick kernel
+//   does.
+// ---------------------------------------------------------
+double runBacktestEvents(
+    int    short_window,
+    int    waiting_period,
+    double hs_exit_change_threshold,
+    double ma_turn_threshold,
+    const PreparedDataset     &data
+)
+{
+    const int nrows = data.size();
+    if(nrows == 0) {
+        return 0.0;
+    }
+
+    const StrategyParams params{short_window, waiting_period,
+                                hs_exit_change_threshold, ma_turn_threshold};
+    const std::vector<int> &exits = data.hs_exits;
+    size_t nextExit = 0;
+    StrategyState st;
+
+    int i = 0;
+    while(i < nrows) {
+        if(st.pos == 0 && !st.in_position) {
+            // Next high-spread exit at or after i (case 1)
+            while(nextExit < exits.size() && exits[nextExit] < i) {
+                nextExit++;
+            }
+            int exitTick = nextExit < exits.size() ? exits[nextExit] : nrows;
+
+            int target = exitTick;
+            if(st.waiting_for_signal && !data.highSpread(i) && short_window >= 1) {
+                // First tick case 2 can fire; stepping resumes from there
+                int ready = std::max(st.high_spread_exit_index + waiting_period, short_window);
+                target = std::min(std::max(ready, i), exitTick);
+            }
+
+            if(target > i) {
+                i = target;
+                if(i >= nrows) {
+                    break;
+                }
+                st.prev_hs = data.highSpread(i - 1);
+            }
+        }
+
+        strategyStep(st, params, i, data.bid[i], data.ask[i], data.mid[i],
+                     data.highSpread(i), data.windowMean(i, short_window), nullptr);
+        i++;
+    }
+
+    flattenPosition(st, nrows - 1, data.bid[nrows - 1], data.ask[nrows - 1], nullptr);
+    return st.cash;
+}
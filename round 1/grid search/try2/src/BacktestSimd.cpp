@@ -0,0 +1,112 @@
+#include "../include/Backtester.h"
+#include "../include/PreparedDataset.h"
+#include "Strategy.h"
+
+// ---------------------------------------------------------
+// Lane-parallel UEC kernel
+//   Runs W parameter sets per vector register (W = 4 under AVX2,
+//   8 under AVX-512), replacing the strategy's branches with lane
+//   masks. Every lane performs the same floating-point operations
+//   in the same order as strategyStep(), and the library is built
+//   with -ffp-contract=off, so PnL is bit-identical to the scalar
+//   kernels. The high-spread flags are data-only, so they stay
+//   scalar and are shared by all lanes.
+//
+//   The kernel body lives in BacktestSimdKernel.inc and is compiled
+//   once per instruction set under "#pragma GCC target": GCC lowers
+//   generic vectors per function before inlining, so a template
+//   inlined into a target("...") wrapper would be split into SSE2
+//   pieces.
+// ---------------------------------------------------------
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BACKTEST_X86_SIMD 1
+#endif
+
+#ifdef BACKTEST_X86_SIMD
+
+#include <immintrin.h>
+
+// LANE_ANY(m): true if any lane of the mask m is set
+#pragma GCC push_options
+#pragma GCC target("avx2")
+namespace avx2 {
+constexpr int W = 4;
+#define LANE_ANY(m) (!_mm256_testz_si256((__m256i)(m), (__m256i)(m)))
+#include "BacktestSimdKernel.inc"
+#undef LANE_ANY
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512dq")
+namespace avx512 {
+constexpr int W = 8;
+#define LANE_ANY(m) (_mm512_test_epi64_mask((__m512i)(m), (__m512i)(m)) != 0)
+#include "BacktestSimdKernel.inc"
+#undef LANE_ANY
+}
+#pragma GCC pop_options
+
+#endif // BACKTEST_X86_SIMD
+
+// ---------------------------------------------------------
+// Dispatch
+// ---------------------------------------------------------
+SimdLevel bestSimdLevel()
+{
+#ifdef BACKTEST_X86_SIMD
+    static const SimdLevel level = []{
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx512f") &&
+           __builtin_cpu_supports("avx512dq")) return SimdLevel::AVX512;
+        if(__builtin_cpu_supports("avx2"))    return SimdLevel::AVX2;
+        return SimdLevel::Scalar;
+    }();
+    return level;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+const char *simdLevelName(SimdLevel level)
+{
+    switch(level) {
+        case SimdLevel::AVX512: return "avx512";
+        case SimdLevel::AVX2:   return "avx2";
+        default:                return "scalar";
+    }
+}
+
+void runBacktestSimd(
+    const ParamBlock      &block,
+    const PreparedDataset &data,
+    double                *pnlOut,
+    SimdLevel              level,
+    const double          *short_avg
+)
+{
+    if((int)level > (int)bestSimdLevel()) {
+        level = bestSimdLevel();
+    }
+    if(block.count == 0) {
+        return;
+    }
+    if(data.size() == 0) {
+        for(int k = 0; k < block.count; k++) {
+            pnlOut[k] = 0.0;
+        }
+        return;
+    }
+
+#ifdef BACKTEST_X86_SIMD
+    if(level == SimdLevel::AVX512) {
+        avx512::runLanes(block, data, pnlOut, short_avg);
+        return;
+    }
+    if(level == SimdLevel::AVX2) {
+        avx2::runLanes(block, data, pnlOut, short_avg);
+        return;
+    }
+#endif
+    runBacktestBatch(block, data, pnlOut, short_avg);
+}
@@ -1,270 +1,338 @@
 #include "../include/Backtester.h"
+#include "../include/RollingWindow.h"
+#include "../include/PreparedDataset.h"
+#include "Strategy.h"
 #include <vector>
+#include <array>
+#include <utility>
 #include <cmath>
 #include <algorithm>
 #include <limits>
 
 // ---------------------------------------------------------
-// Constants used by the strategy
+// Backtest modes
+//   PnLOnly - only the O(1) state the decisions need
+//   Traced  - additionally records the full per-tick history
 // ---------------------------------------------------------
-static const int    LONG_WINDOW           = 500;
-static const double HIGH_SPREAD_THRESHOLD = 1.3;
-static const int    POSITION_SIZE         = 100;
-static const double FEES                  = 0.002;
-static const int    POSITION_LIMIT        = 100;
+enum class BacktestMode { PnLOnly, Traced };
 
-// Helper: calculates the mean of the last N elements in an array
-static double mean_of_last_N(const std::vector<double>& arr, int N)
-{
-    double sum = 0.0;
-    int sz = (int)arr.size();
-    for (int i = sz - N; i < sz; i++) {
-        sum += arr[i];
+// ---------------------------------------------------------
+// Tick sources
+//   StreamingSource - raw vectors, derived columns computed per
+//                     tick and the short average streamed
+//   PreparedSource  - precomputed PreparedDataset columns, short
+//                     average from the mid prefix sums
+//   FixedSource<SW> - PreparedSource with the short window fixed at
+//                     compile time
+// ---------------------------------------------------------
+struct StreamingSource {
+    const std::vector<int>    &ticks;
+    const std::vector<double> &bids;
+    const std::vector<double> &asks;
+    RollingWindow             &short_win;
+
+    int    size()          const { return (int)ticks.size(); }
+    int    tick(int i)     const { return ticks[i]; }
+    double bid(int i)      const { return bids[i]; }
+    double ask(int i)      const { return asks[i]; }
+    double mid(int i)      const { return 0.5 * (bids[i] + asks[i]); }
+    double spread(int i)   const { return asks[i] - bids[i]; }
+    bool   highSpread(int i) const { return spread(i) >= HIGH_SPREAD_THRESHOLD; }
+    double shortAvg(int)   const { return short_win.mean(); }
+    void   advance(int, double m) { short_win.push(m); }
+};
+
+struct PreparedSource {
+    const PreparedDataset &data;
+    int                    short_window;
+
+    int    size()          const { return data.size(); }
+    int    tick(int i)     const { return data.ticks[i]; }
+    double bid(int i)      const { return data.bid[i]; }
+    double ask(int i)      const { return data.ask[i]; }
+    double mid(int i)      const { return data.mid[i]; }
+    double spread(int i)   const { return data.spread[i]; }
+    bool   highSpread(int i) const { return data.highSpread(i); }
+    double shortAvg(int i) const { return data.windowMean(i, short_window); }
+    void   advance(int, double) {}
+};
+
+template <int SW>
+struct FixedSource : PreparedSource {
+    // Same expression as PreparedDataset::windowMean(), with the lag
+    // and divisor folded into constants
+    double shortAvg(int i) const
+    {
+        if(i < SW) {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        return (data.mid_prefix[i] - data.mid_prefix[i - SW]) / SW;
     }
-    return sum / N;
-}
+};
 
 // ---------------------------------------------------------
-// runBacktest(): Implementation of the trading strategy
+// runKernel(): Implementation of the trading strategy
 // ---------------------------------------------------------
-double runBacktest(
-    int    short_window, 
-    int    waiting_period,
-    double hs_exit_change_threshold,
-    double ma_turn_threshold,
-    const std::vector<int>    &ticks,
-    const std::vector<double> &bids,
-    const std::vector<double> &asks
+template <BacktestMode Mode, typename Source>
+static double runKernel(
+    Source &src,
+    const StrategyParams      &params,
+    BacktestTrace             *trace,
+    std::vector<TradeRecord>  *trades
 )
 {
-    int nrows = (int)ticks.size();
+    constexpr bool traced = (Mode == BacktestMode::Traced);
+
+    int nrows = src.size();
     if(nrows == 0) {
         return 0.0;
     }
 
-    // "Historical" arrays for logging strategy state
-    std::vector<int>    timestamp;
-    std::vector<double> bid_vec;
-    std::vector<double> ask_vec;
-    std::vector<double> mid_price;
-    std::vector<double> spread;
-    std::vector<double> short_avg;
-    std::vector<double> long_avg;
-    std::vector<int>    position_log;
-    std::vector<bool>   in_high_spread;
-    std::vector<double> trade_profit;
-
-    // Strategy states
-    bool   in_position                = false;
-    bool   position_is_long           = false;
-    double current_position_extreme   = 0.0;
-    bool   waiting_for_signal         = false;
-    int    high_spread_exit_index     = -1;
-    double last_high_spread_exit_savg = 0.0;
+    // The long window only feeds the trace
+    RollingWindow long_win;
+    if constexpr (traced) {
+        long_win.reset(LONG_WINDOW);
+        trace->clear();
+        trace->reserve(nrows);
+        trades = &trace->trades;
+    }
+    if(trades) {
+        trades->clear();
+    }
 
-    // Track position and cash
-    int    pos  = 0;
-    double cash = 0.0;
-
-    // Helper to record trade profit
-    auto record_trade_section = [&](int entry_i, int exit_i,
-                                  double entry_price, double exit_price,
-                                  int position_size)
-    {
-        double profit = 0.0;
-        if(position_size > 0) {
-            profit = (exit_price - entry_price) * position_size;
-        }
-        else if(position_size < 0) {
-            profit = (entry_price - exit_price) * std::abs(position_size);
-        }
-        return profit;
-    };
-
-    // Helper to update historical data
-    auto update_history = [&](int t, double b, double a,
-                            double savg, double lavg,
-                            int newpos, bool hs, double trp)
-    {
-        timestamp.push_back(t);
-        bid_vec.push_back(b);
-        ask_vec.push_back(a);
-        double m = 0.5 * (b + a);
-        mid_price.push_back(m);
-        spread.push_back(a - b);
-        short_avg.push_back(savg);
-        long_avg.push_back(lavg);
-        position_log.push_back(newpos);
-        in_high_spread.push_back(hs);
-        trade_profit.push_back(trp);
-    };
+    StrategyState st;
 
     // Main backtest loop
     for (int i = 0; i < nrows; i++)
     {
-        double b = bids[i];
-        double a = asks[i];
-        double m = 0.5 * (b + a);
-        double spr = a - b;
-        bool hs = (spr >= HIGH_SPREAD_THRESHOLD);
+        double b = src.bid(i);
+        double a = src.ask(i);
+        double m = src.mid(i);
+        bool hs = src.highSpread(i);
 
-        // Calculate short/long rolling averages
-        double s_avg = std::numeric_limits<double>::quiet_NaN();
-        if((int)mid_price.size() >= short_window) {
-            s_avg = mean_of_last_N(mid_price, short_window);
-        }
-        double l_avg = std::numeric_limits<double>::quiet_NaN();
-        if((int)mid_price.size() >= LONG_WINDOW) {
-            l_avg = mean_of_last_N(mid_price, LONG_WINDOW);
-        }
+        // Calculate short rolling average
+        double s_avg = src.shortAvg(i);
 
-        int order_quantity = 0;
-        double trade_p = 0.0;
+        // Decide, apply the order and update the strategy state
+        double trade_p = strategyStep(st, params, i, b, a, m, hs, s_avg, trades);
 
-        // 0) If in position => check if short_avg turned from extreme
-        if(!std::isnan(s_avg) && in_position) {
-            if(position_is_long) {
-                if(s_avg > current_position_extreme) {
-                    current_position_extreme = s_avg;
-                } else {
-                    if((current_position_extreme - s_avg) >= ma_turn_threshold) {
-                        // exit
-                        int exit_index = (int)timestamp.size();
-                        int entry_index = -1;
-                        for(int k=(int)position_log.size()-1; k>=0; k--) {
-                            if(position_log[k] == 0) {
-                                entry_index = k+1;
-                                break;
-                            }
-                        }
-                        if(entry_index >= 0 && entry_index < exit_index) {
-                            double ep = mid_price[entry_index];
-                            double xp = m;
-                            trade_p = record_trade_section(entry_index, exit_index, ep, xp, pos);
-                        }
-                        order_quantity = -pos; // close
-                        in_position = false;
-                        position_is_long = false;
-                        current_position_extreme = 0.0;
-                    }
-                }
-            }
-            else { // short
-                if(s_avg < current_position_extreme) {
-                    current_position_extreme = s_avg;
-                } else {
-                    if((s_avg - current_position_extreme) >= ma_turn_threshold) {
-                        int exit_index = (int)timestamp.size();
-                        int entry_index = -1;
-                        for(int k=(int)position_log.size()-1; k>=0; k--) {
-                            if(position_log[k] == 0) {
-                                entry_index = k+1;
-                                break;
-                            }
-                        }
-                        if(entry_index >= 0 && entry_index < exit_index) {
-                            double ep = mid_price[entry_index];
-                            double xp = m;
-                            trade_p = record_trade_section(entry_index, exit_index, ep, xp, pos);
-                        }
-                        order_quantity = -pos;
-                        in_position = false;
-                        position_is_long = false;
-                        current_position_extreme = 0.0;
-                    }
-                }
-            }
+        // record to history
+        if constexpr (traced) {
+            double l_avg = long_win.mean();
+            double use_savg = std::isnan(s_avg) ? m : s_avg;
+            double use_lavg = std::isnan(l_avg) ? m : l_avg;
+            trace->timestamp.push_back(src.tick(i));
+            trace->bid.push_back(b);
+            trace->ask.push_back(a);
+            trace->mid_price.push_back(m);
+            trace->spread.push_back(src.spread(i));
+            trace->short_avg.push_back(use_savg);
+            trace->long_avg.push_back(use_lavg);
+            trace->position.push_back(st.pos);
+            trace->in_high_spread.push_back(hs);
+            trace->trade_profit.push_back(trade_p);
+            long_win.push(m);
         }
+        src.advance(i, m);
+    }
 
-        // 1) Just exited HS
-        if(!timestamp.empty() && in_high_spread.back() && !hs) {
-            high_spread_exit_index = (int)timestamp.size() - 1;
-            if(!std::isnan(s_avg)) {
-                last_high_spread_exit_savg = s_avg;
-            } else {
-                last_high_spread_exit_savg = m;
-            }
-            waiting_for_signal = true;
-        }
-        // 2) waited WAITING_PERIOD => check threshold for new entry
-        else if(waiting_for_signal 
-                && ((int)timestamp.size() - high_spread_exit_index) >= waiting_period
-                && pos == 0
-                && !hs)
-        {
-            if(!std::isnan(s_avg)) {
-                double diff = std::fabs(s_avg - last_high_spread_exit_savg);
-                if(diff >= hs_exit_change_threshold) {
-                    if(m > s_avg) {
-                        order_quantity = POSITION_SIZE;
-                        in_position = true;
-                        position_is_long = true;
-                        current_position_extreme = s_avg;
-                    } else if(m < s_avg) {
-                        order_quantity = -POSITION_SIZE;
-                        in_position = true;
-                        position_is_long = false;
-                        current_position_extreme = s_avg;
-                    }
-                    waiting_for_signal = false;
-                }
-            }
-        }
-        // 3) in HS & have a position => close now
-        else if(hs && pos != 0) {
-            int exit_index = (int)timestamp.size();
-            int entry_index = -1;
-            for(int k=(int)position_log.size()-1; k>=0; k--) {
-                if(position_log[k] == 0) {
-                    entry_index = k+1;
-                    break;
-                }
-            }
-            if(entry_index >= 0 && entry_index < exit_index) {
-                double ep = mid_price[entry_index];
-                double xp = m;
-                trade_p = record_trade_section(entry_index, exit_index, ep, xp, pos);
-            }
-            order_quantity = -pos;
-            in_position = false;
-            position_is_long = false;
-            current_position_extreme = 0.0;
-        }
+    // flatten final position
+    flattenPosition(st, nrows - 1, src.bid(nrows - 1), src.ask(nrows - 1), trades);
 
-        // Apply position limits and update cash
-        int actual_order = order_quantity;
-        if(actual_order > 0 && (pos + actual_order) > POSITION_LIMIT) {
-            actual_order = 0;
-        }
-        if(actual_order < 0 && (pos + actual_order) < -POSITION_LIMIT) {
-            actual_order = 0;
-        }
-        if(actual_order > 0) {
-            cash -= a * actual_order * (1.0 + FEES);
-        }
-        else if(actual_order < 0) {
-            cash += b * (-actual_order) * (1.0 - FEES);
-        }
-        int new_pos = pos + actual_order;
+    return st.cash;
+}
 
-        // record to history
-        double use_savg = std::isnan(s_avg) ? m : s_avg;
-        double use_lavg = std::isnan(l_avg) ? m : l_avg;
-        update_history(ticks[i], b, a, use_savg, use_lavg, new_pos, hs, trade_p);
+// ---------------------------------------------------------
+// BacktestTrace helpers
+// ---------------------------------------------------------
+void BacktestTrace::clear()
+{
+    timestamp.clear();
+    bid.clear();
+    ask.clear();
+    mid_price.clear();
+    spread.clear();
+    short_avg.clear();
+    long_avg.clear();
+    position.clear();
+    in_high_spread.clear();
+    trade_profit.clear();
+    trades.clear();
+}
 
-        pos = new_pos;
-    }
+void BacktestTrace::reserve(size_t n)
+{
+    timestamp.reserve(n);
+    bid.reserve(n);
+    ask.reserve(n);
+    mid_price.reserve(n);
+    spread.reserve(n);
+    short_avg.reserve(n);
+    long_avg.reserve(n);
+    position.reserve(n);
+    in_high_spread.reserve(n);
+    trade_profit.reserve(n);
+}
 
-    // flatten final position
-    if(pos != 0) {
-        double final_bid = bids[nrows - 1];
-        double final_ask = asks[nrows - 1];
-        if(pos > 0) {
-            cash += final_bid * pos * (1.0 - FEES);
-        } else {
-            cash -= final_ask * (-pos) * (1.0 + FEES);
-        }
+// ---------------------------------------------------------
+// Public entry points
+// ---------------------------------------------------------
+
+// Short window reused per thread, so the PnL-only path never
+// allocates once warmed up
+static RollingWindow &streamingWindow(int short_window)
+{
+    static thread_local RollingWindow short_win;
+    short_win.reset(short_window);
+    return short_win;
+}
+
+double runBacktest(
+    int    short_window,
+    int    waiting_period,
+    double hs_exit_change_threshold,
+    double ma_turn_threshold,
+    const std::vector<int>    &ticks,
+    const std::vector<double> &bids,
+    const std::vector<double> &asks
+)
+{
+    StreamingSource src{ticks, bids, asks, streamingWindow(short_window)};
+    return runKernel<BacktestMode::PnLOnly>(
+        src, {short_window, waiting_period, hs_exit_change_threshold, ma_turn_threshold},
+        nullptr, nullptr);
+}
+
+double runBacktest(
+    int    short_window,
+    int    waiting_period,
+    double hs_exit_change_threshold,
+    double ma_turn_threshold,
+    const std::vector<int>    &ticks,
+    const std::vector<double> &bids,
+    const std::vector<double> &asks,
+    BacktestTrace             &trace
+)
+{
+    StreamingSource src{ticks, bids, asks, streamingWindow(short_window)};
+    return runKernel<BacktestMode::Traced>(
+        src, {short_window, waiting_period, hs_exit_change_threshold, ma_turn_threshold},
+        &trace, nullptr);
+}
+
+double runBacktest(
+    int    short_window,
+    int    waiting_period,
+    double hs_exit_change_threshold,
+    double ma_turn_threshold,
+    const std::vector<int>    &ticks,
+    const std::vector<double> &bids,
+    const std::vector<double> &asks,
+    std::vector<TradeRecord>  &trades
+)
+{
+    StreamingSource src{ticks, bids, asks, streamingWindow(short_window)};
+    return runKernel<BacktestMode::PnLOnly>(
+        src, {short_window, waiting_period, hs_exit_change_threshold, ma_turn_threshold},
+        nullptr, &trades);
+}
+
+double runBacktest(
+    int    short_window,
+    int    waiting_period,
+    double hs_exit_change_threshold,
+    double ma_turn_threshold,
+    const PreparedDataset     &data
+)
+{
+    if(FixedBacktestFn fn = fixedBacktestKernel(short_window)) {
+        return fn(waiting_period, hs_exit_change_threshold, ma_turn_threshold, data);
     }
+    return runBacktestGeneric(short_window, waiting_period,
+                              hs_exit_change_threshold, ma_turn_threshold, data);
+}
+
+double runBacktest(
+    int    short_window,
+    int    waiting_period,
+    double hs_exit_change_threshold,
+    double ma_turn_threshold,
+    int    position_size,
+    const PreparedDataset     &data
+)
+{
+    PreparedSource src{data, short_window};
+    return runKernel<BacktestMode::PnLOnly>(
+        src, {short_window, waiting_period, hs_exit_change_threshold, ma_turn_threshold,
+              position_size},
+        nullptr, nullptr);
+}
+
+double runBacktest(
+    int    short_window,
+    int    waiting_period,
+    double hs_exit_change_threshold,
+    double ma_turn_threshold,
+    const StrategyVariant     &variant,
+    const PreparedDataset     &data
+)
+{
+    PreparedSource src{data, short_window};
+    return runKernel<BacktestMode::PnLOnly>(
+        src, {short_window, waiting_period, hs_exit_change_threshold, ma_turn_threshold,
+              POSITION_SIZE, variant.hold_during_high_spread, variant.entry_sides},
+        nullptr, nullptr);
+}
+
+double runBacktestGeneric(
+    int    short_window,
+    int    waiting_period,
+    double hs_exit_change_threshold,
+    double ma_turn_threshold,
+    const PreparedDataset     &data
+)
+{
+    PreparedSource src{data, short_window};
+    return runKernel<BacktestMode::PnLOnly>(
+        src, {short_window, waiting_period, hs_exit_change_threshold, ma_turn_threshold},
+        nullptr, nullptr);
+}
 
-    return cash;
-} 
\ No newline at end of file
+template <int SW>
+double runBacktestFixed(
+    int    waiting_period,
+    double hs_exit_change_threshold,
+    double ma_turn_threshold,
+    const PreparedDataset     &data
+)
+{
+    static_assert(SW >= 1, "short window must be positive");
+    FixedSource<SW> src{{data, SW}};
+    return runKernel<BacktestMode::PnLOnly>(
+        src, {SW, waiting_period, hs_exit_change_threshold, ma_turn_threshold},
+        nullptr, nullptr);
+}
+
+// ---------------------------------------------------------
+// Fixed-window dispatch table
+//   One runBacktestFixed<SW> instance per window in
+//   [FIXED_WINDOW_MIN, FIXED_WINDOW_MAX]; taking their addresses
+//   here also instantiates (and exports) them.
+// ---------------------------------------------------------
+template <int... Offsets>
+static constexpr std::array<FixedBacktestFn, sizeof...(Offsets)>
+makeFixedTable(std::integer_sequence<int, Offsets...>)
+{
+    return {{ &runBacktestFixed<FIXED_WINDOW_MIN + Offsets>... }};
+}
+
+static constexpr auto s_fixedTable = makeFixedTable(
+    std::make_integer_sequence<int, FIXED_WINDOW_MAX - FIXED_WINDOW_MIN + 1>{});
+
+FixedBacktestFn fixedBacktestKernel(int short_window)
+{
+    if(short_window < FIXED_WINDOW_MIN || short_window > FIXED_WINDOW_MAX) {
+        return nullptr;
+    }
+    return s_fixedTable[short_window - FIXED_WINDOW_MIN];
+}
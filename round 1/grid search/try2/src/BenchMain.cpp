@@ -0,0 +1,372 @@
+#include "../include/Backtester.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <chrono>
+#include <iomanip>
+#include <functional>
+#include <algorithm>
+
+//-----------------------------------------------
+// Benchmark data
+//-----------------------------------------------
+static std::vector<int>    g_ticks;
+static std::vector<double> g_bids;
+static std::vector<double> g_asks;
+
+struct BenchCombo {
+    int    short_window;
+    int    waiting_period;
+    double hs_exit_change_threshold;
+    double ma_turn_threshold;
+};
+
+//-----------------------------------------------
+// Same ±10% / 1% grid as the fuzzer, sampled evenly down to n combos
+//-----------------------------------------------
+static std::vector<BenchCombo> sampleGrid(size_t n)
+{
+    std::vector<int>    ivals;
+    std::vector<double> hsx, mat;
+    for(int i = -10; i <= 10; i++){
+        double factor = (100.0 + i)/100.0;
+        ivals.push_back((int)std::round(80 * factor));
+        hsx.push_back(0.2 * factor);
+        mat.push_back(0.9 * factor);
+    }
+    std::vector<BenchCombo> all;
+    for(int sw : ivals)
+        for(int wp : ivals)
+            for(double h : hsx)
+                for(double m : mat)
+                    all.push_back({sw, wp, h, m});
+
+    if(n >= all.size()) return all;
+    std::vector<BenchCombo> out;
+    out.reserve(n);
+    double stride = (double)all.size() / n;
+    for(size_t k = 0; k < n; k++){
+        out.push_back(all[(size_t)(k * stride)]);
+    }
+    return out;
+}
+
+//-----------------------------------------------
+// Times fn() and returns seconds
+//-----------------------------------------------
+static double timeIt(const std::function<void()> &fn)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    fn();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(t1 - t0).count();
+}
+
+//-----------------------------------------------
+// Prints one benchmark row
+//   bytesPerCombo: modelled tick-column bytes per combo (columns
+//                  read per tick x ticks / combos sharing a pass).
+//                  Not a counter: the columns of a 50k-tick file
+//                  fit in L2/L3, so the GB/s figure is an upper
+//                  bound on memory traffic, and only the time and
+//                  us/combo columns are measured.
+//-----------------------------------------------
+static void printRow(const std::string &name, size_t combos, double secs, double bytesPerCombo)
+{
+    double usPerCombo = 1e6 * secs / combos;
+    std::cout << std::left << std::setw(22) << name << std::right
+              << std::setw(10) << std::fixed << std::setprecision(3) << secs << " s"
+              << std::setw(12) << std::setprecision(1) << usPerCombo << " us/combo"
+              << std::setw(12) << std::setprecision(1) << bytesPerCombo / 1024.0 << " KiB/combo*"
+              << std::setw(10) << std::setprecision(2) << (bytesPerCombo * combos / secs) / 1e9 << " GB/s*"
+              << std::endl;
+}
+
+//-----------------------------------------------
+// Scalar vs batched kernel on the same combos
+//-----------------------------------------------
+static void benchBatch(const PreparedDataset &data, const std::vector<BenchCombo> &combos)
+{
+    // Columns touched per tick: bid, ask, mid, mid_prefix + 1 hs bit
+    const double bytesPerTick = 4 * sizeof(double) + 1.0 / 8.0;
+    const double bytesPerPass = bytesPerTick * data.size();
+
+    std::vector<double> scalarPnl(combos.size());
+    std::vector<double> batchPnl(combos.size());
+
+    double scalarSecs = timeIt([&]{
+        for(size_t k = 0; k < combos.size(); k++){
+            const BenchCombo &c = combos[k];
+            scalarPnl[k] = runBacktest(c.short_window, c.waiting_period,
+                                       c.hs_exit_change_threshold, c.ma_turn_threshold, data);
+        }
+    });
+
+    double batchSecs = timeIt([&]{
+        ParamBlock block;
+        for(size_t start = 0; start < combos.size(); start += PARAM_BLOCK_SIZE){
+            block.clear();
+            for(size_t k = start; k < combos.size() && !block.full(); k++){
+                const BenchCombo &c = combos[k];
+                block.add(c.short_window, c.waiting_period,
+                          c.hs_exit_change_threshold, c.ma_turn_threshold);
+            }
+            runBacktestBatch(block, data, &batchPnl[start]);
+        }
+    });
+
+    size_t mismatches = 0;
+    for(size_t k = 0; k < combos.size(); k++){
+        if(scalarPnl[k] != batchPnl[k]) mismatches++;
+    }
+
+    std::cout << "\n== runBacktest vs runBacktestBatch (" << combos.size() << " combos, "
+              << data.size() << " ticks) ==" << std::endl;
+    printRow("scalar (prepared)", combos.size(), scalarSecs, bytesPerPass);
+    printRow("batch x" + std::to_string(PARAM_BLOCK_SIZE), combos.size(), batchSecs,
+             bytesPerPass / PARAM_BLOCK_SIZE);
+    std::cout << "speedup " << std::setprecision(2) << scalarSecs / batchSecs
+              << "x, PnL mismatches: " << mismatches << std::endl;
+}
+
+//-----------------------------------------------
+// Batched kernel vs the SIMD kernel at every supported level
+//-----------------------------------------------
+static void benchSimd(const PreparedDataset &data, const std::vector<BenchCombo> &combos)
+{
+    const double bytesPerTick = 4 * sizeof(double) + 1.0 / 8.0;
+    const double bytesPerPass = bytesPerTick * data.size();
+
+    auto runBlocks = [&](std::vector<double> &out, SimdLevel level, bool simd){
+        ParamBlock block;
+        for(size_t start = 0; start < combos.size(); start += PARAM_BLOCK_SIZE){
+            block.clear();
+            for(size_t k = start; k < combos.size() && !block.full(); k++){
+                const BenchCombo &c = combos[k];
+                block.add(c.short_window, c.waiting_period,
+                          c.hs_exit_change_threshold, c.ma_turn_threshold);
+            }
+            if(simd) runBacktestSimd(block, data, &out[start], level);
+            else     runBacktestBatch(block, data, &out[start]);
+        }
+    };
+
+    std::vector<double> batchPnl(combos.size());
+    double batchSecs = timeIt([&]{ runBlocks(batchPnl, SimdLevel::Scalar, false); });
+
+    std::cout << "\n== runBacktestBatch vs runBacktestSimd (" << combos.size() << " combos, "
+              << data.size() << " ticks, best: " << simdLevelName(bestSimdLevel()) << ") ==" << std::endl;
+    printRow("batch x" + std::to_string(PARAM_BLOCK_SIZE), combos.size(), batchSecs,
+             bytesPerPass / PARAM_BLOCK_SIZE);
+
+    for(SimdLevel level : {SimdLevel::AVX2, SimdLevel::AVX512}){
+        if(level > bestSimdLevel()) continue;
+        std::vector<double> simdPnl(combos.size());
+        double simdSecs = timeIt([&]{ runBlocks(simdPnl, level, true); });
+
+        size_t mismatches = 0;
+        for(size_t k = 0; k < combos.size(); k++){
+            if(batchPnl[k] != simdPnl[k]) mismatches++;
+        }
+        printRow(std::string("simd ") + simdLevelName(level), combos.size(), simdSecs,
+                 bytesPerPass / PARAM_BLOCK_SIZE);
+        std::cout << "speedup " << std::setprecision(2) << batchSecs / simdSecs
+                  << "x, PnL mismatches: " << mismatches << std::endl;
+    }
+}
+
+//-----------------------------------------------
+// Runtime short window vs the fixed-window dispatch table
+//-----------------------------------------------
+static void benchFixed(const PreparedDataset &data, const std::vector<BenchCombo> &combos)
+{
+    const double bytesPerPass = (4 * sizeof(double) + 1.0 / 8.0) * data.size();
+
+    std::vector<double> genericPnl(combos.size());
+    std::vector<double> fixedPnl(combos.size());
+    size_t specialized = 0;
+
+    double genericSecs = timeIt([&]{
+        for(size_t k = 0; k < combos.size(); k++){
+            const BenchCombo &c = combos[k];
+            genericPnl[k] = runBacktestGeneric(c.short_window, c.waiting_period,
+                                               c.hs_exit_change_threshold, c.ma_turn_threshold, data);
+        }
+    });
+
+    double fixedSecs = timeIt([&]{
+        for(size_t k = 0; k < combos.size(); k++){
+            const BenchCombo &c = combos[k];
+            fixedPnl[k] = runBacktest(c.short_window, c.waiting_period,
+                                      c.hs_exit_change_threshold, c.ma_turn_threshold, data);
+        }
+    });
+
+    size_t mismatches = 0;
+    for(size_t k = 0; k < combos.size(); k++){
+        if(genericPnl[k] != fixedPnl[k]) mismatches++;
+        if(fixedBacktestKernel(combos[k].short_window)) specialized++;
+    }
+
+    std::cout << "\n== runBacktestGeneric vs runBacktestFixed<SW> (" << combos.size() << " combos, "
+              << specialized << " specialized, windows " << FIXED_WINDOW_MIN << "-"
+              << FIXED_WINDOW_MAX << ") ==" << std::endl;
+    printRow("generic", combos.size(), genericSecs, bytesPerPass);
+    printRow("fixed (dispatched)", combos.size(), fixedSecs, bytesPerPass);
+    std::cout << "speedup " << std::setprecision(2) << genericSecs / fixedSecs
+              << "x, PnL mismatches: " << mismatches << std::endl;
+}
+
+//-----------------------------------------------
+// Tick-by-tick vs event-driven kernel
+//-----------------------------------------------
+static void benchEvents(const PreparedDataset &data, const std::vector<BenchCombo> &combos)
+{
+    const double bytesPerPass = (4 * sizeof(double) + 1.0 / 8.0) * data.size();
+
+    std::vector<double> tickPnl(combos.size());
+    std::vector<double> eventPnl(combos.size());
+
+    double tickSecs = timeIt([&]{
+        for(size_t k = 0; k < combos.size(); k++){
+            const BenchCombo &c = combos[k];
+            tickPnl[k] = runBacktest(c.short_window, c.waiting_period,
+                                     c.hs_exit_change_threshold, c.ma_turn_threshold, data);
+        }
+    });
+
+    double eventSecs = timeIt([&]{
+        for(size_t k = 0; k < combos.size(); k++){
+            const BenchCombo &c = combos[k];
+            eventPnl[k] = runBacktestEvents(c.short_window, c.waiting_period,
+                                            c.hs_exit_change_threshold, c.ma_turn_threshold, data);
+        }
+    });
+
+    size_t mismatches = 0;
+    for(size_t k = 0; k < combos.size(); k++){
+        if(tickPnl[k] != eventPnl[k]) mismatches++;
+    }
+
+    std::cout << "\n== runBacktest vs runBacktestEvents (" << combos.size() << " combos, "
+              << data.hs_entries.size() << " high-spread runs) ==" << std::endl;
+    printRow("tick-by-tick", combos.size(), tickSecs, bytesPerPass);
+    // Skipped ticks are never loaded; scale by time as a rough estimate
+    printRow("event-driven", combos.size(), eventSecs, bytesPerPass * eventSecs / tickSecs);
+    std::cout << "speedup " << std::setprecision(2) << tickSecs / eventSecs
+              << "x, PnL mismatches: " << mismatches << std::endl;
+}
+
+//-----------------------------------------------
+// Per-lane short averages vs one shared s_avg series per
+// short_window group (the fuzzer's window schedule)
+//-----------------------------------------------
+static void benchWindowGroups(const PreparedDataset &data, std::vector<BenchCombo> combos)
+{
+    const double bytesPerPass = (4 * sizeof(double) + 1.0 / 8.0) * data.size();
+
+    std::stable_sort(combos.begin(), combos.end(),
+                     [](const BenchCombo &a, const BenchCombo &b){
+                         return a.short_window < b.short_window;
+                     });
+
+    // Runs every group block by block, with or without its shared series
+    auto runGroups = [&](std::vector<double> &out, bool simd, bool shared){
+        ParamBlock block;
+        std::vector<double> shortAvg;
+        size_t begin = 0;
+        while(begin < combos.size()){
+            size_t end = begin;
+            while(end < combos.size() && combos[end].short_window == combos[begin].short_window) end++;
+            if(shared){
+                shortAvg.assign(data.size(), 0.0);
+                data.windowMeans(combos[begin].short_window, shortAvg.data());
+            }
+            for(size_t start = begin; start < end; start += PARAM_BLOCK_SIZE){
+                block.clear();
+                for(size_t k = start; k < end && !block.full(); k++){
+                    const BenchCombo &c = combos[k];
+                    block.add(c.short_window, c.waiting_period,
+                              c.hs_exit_change_threshold, c.ma_turn_threshold);
+                }
+                const double *series = shared ? shortAvg.data() : nullptr;
+                if(simd) runBacktestSimd(block, data, &out[start], bestSimdLevel(), series);
+                else     runBacktestBatch(block, data, &out[start], series);
+            }
+            begin = end;
+        }
+    };
+
+    std::cout << "\n== per-lane vs shared short-average series (" << combos.size()
+              << " combos grouped by short_window) ==" << std::endl;
+    for(bool simd : {false, true}){
+        std::vector<double> lanePnl(combos.size());
+        std::vector<double> sharedPnl(combos.size());
+        double laneSecs   = timeIt([&]{ runGroups(lanePnl, simd, false); });
+        double sharedSecs = timeIt([&]{ runGroups(sharedPnl, simd, true); });
+
+        size_t mismatches = 0;
+        for(size_t k = 0; k < combos.size(); k++){
+            if(lanePnl[k] != sharedPnl[k]) mismatches++;
+        }
+        std::string name = simd ? std::string("simd ") + simdLevelName(bestSimdLevel()) : "batch";
+        printRow(name + " per-lane", combos.size(), laneSecs, bytesPerPass / PARAM_BLOCK_SIZE);
+        printRow(name + " shared", combos.size(), sharedSecs, bytesPerPass / PARAM_BLOCK_SIZE);
+        std::cout << "speedup " << std::setprecision(2) << laneSecs / sharedSecs
+                  << "x, PnL mismatches: " << mismatches << std::endl;
+    }
+}
+
+//-----------------------------------------------
+// Main function
+//   backtest_bench [csv] [combos]
+//-----------------------------------------------
+int main(int argc, char* argv[])
+{
+    std::string csvPath = "../data/UEC.csv";
+    size_t nCombos = 4096;
+    if(argc > 1) csvPath = argv[1];
+    if(argc > 2) nCombos = std::stoul(argv[2]);
+
+    std::ifstream fin(csvPath);
+    if(!fin.is_open()){
+        std::cerr << "Error: cannot open " << csvPath << std::endl;
+        return 1;
+    }
+    std::string line;
+    std::getline(fin, line); // header
+    while(std::getline(fin, line)){
+        if(line.empty()) continue;
+        std::stringstream ss(line);
+        std::string c1, c2, c3;
+        if(std::getline(ss, c1, ',') &&
+           std::getline(ss, c2, ',') &&
+           std::getline(ss, c3, ','))
+        {
+            g_ticks.push_back(std::stoi(c1));
+            g_bids.push_back(std::stod(c2));
+            g_asks.push_back(std::stod(c3));
+        }
+    }
+    if(g_ticks.empty()){
+        std::cerr << "Error: No data loaded from " << csvPath << std::endl;
+        return 1;
+    }
+
+    PreparedDataset data(g_ticks, g_bids, g_asks);
+    std::vector<BenchCombo> combos = sampleGrid(nCombos);
+    std::cout << "Loaded " << data.size() << " rows from " << csvPath << std::endl;
+    std::cout << "* modelled from the tick columns each kernel reads, not measured" << std::endl;
+
+    benchBatch(data, combos);
+    benchSimd(data, combos);
+    benchFixed(data, combos);
+    benchEvents(data, combos);
+    benchWindowGroups(data, combos);
+
+    return 0;
+}
@@ -1,4 +1,11 @@
 #include "../include/Backtester.h"
+#include "../include/GridRefiner.h"
+#include "../include/ParamSampler.h"
+#include "../include/CmaEs.h"
+#include "../include/PartialResults.h"
+#include "../include/SweepProtocol.h"
+#include "../include/GridFilter.h"
+#include "../include/WorkStealing.h"
 
 #include <iostream>
 #include <fstream>
@@ -6,12 +13,22 @@
 #include <string>
 #include <vector>
 #include <thread>
-#include <mutex>
 #include <atomic>
+#include <cstdint>
+#include <cassert>
 #include <algorithm>
+#include <tuple>
 #include <cmath>
 #include <chrono>
 #include <iomanip>
+#include <limits>
+#include <map>
+#include <set>
+#include <deque>
+#include <memory>
+#include <random>
+
+#include <poll.h>
 
 //-----------------------------------------------
 // Global variables for CSV data
@@ -21,6 +38,10 @@ static std::vector<double> g_bids;
 static std::vector<double> g_asks;
 static int                 g_nrows = 0;
 
+// Parameter-independent columns, built once after loading and
+// shared read-only by all workers
+static PreparedDataset     g_data;
+
 //-----------------------------------------------
 // Structure to hold parameter combinations and results
 //-----------------------------------------------
@@ -33,80 +54,418 @@ struct ParamResult {
 };
 
 //-----------------------------------------------
-// Generate fuzzy parameter values (±10% range in 1% steps)
+// Parameter value at an offset of i% from the base
 //-----------------------------------------------
-std::vector<int> fuzzIntParam(int baseVal)
+int fuzzIntStep(int baseVal, int i)
+{
+    double factor = (100.0 + i)/100.0; 
+    double dval = baseVal * factor;
+    int iv = (int)std::round(dval);
+    if(iv < 1) iv = 1; // Avoid zero values
+    return iv;
+}
+
+double fuzzDoubleStep(double baseVal, int i)
 {
-    // Produce 21 steps from 90% to 110%
+    double factor = (100.0 + i)/100.0;
+    double dv = baseVal * factor;
+    if(dv <= 0.0) dv = 1e-6; // Avoid non-positive values
+    return dv;
+}
+
+//-----------------------------------------------
+// Generate fuzzy parameter values (±span% range in 1% steps)
+//-----------------------------------------------
+std::vector<int> fuzzIntParam(int baseVal, int span = 10)
+{
+    // Produce 2*span+1 steps, 90% to 110% by default
     std::vector<int> vals;
-    for(int i = -10; i <= 10; i++){
-        double factor = (100.0 + i)/100.0; 
-        double dval = baseVal * factor;
-        int iv = (int)std::round(dval);
-        if(iv < 1) iv = 1; // Avoid zero values
-        vals.push_back(iv);
+    for(int i = -span; i <= span; i++){
+        vals.push_back(fuzzIntStep(baseVal, i));
     }
     std::sort(vals.begin(), vals.end());
     return vals;
 }
 
-std::vector<double> fuzzDoubleParam(double baseVal)
+std::vector<double> fuzzDoubleParam(double baseVal, int span = 10)
 {
     std::vector<double> vals;
-    for(int i = -10; i <= 10; i++){
-        double factor = (100.0 + i)/100.0;
-        double dv = baseVal * factor;
-        if(dv <= 0.0) dv = 1e-6; // Avoid non-positive values
-        vals.push_back(dv);
+    for(int i = -span; i <= span; i++){
+        vals.push_back(fuzzDoubleStep(baseVal, i));
     }
     std::sort(vals.begin(), vals.end());
     return vals;
 }
 
+//-----------------------------------------------
+// Canonicalize the combo list: sort by parameters and drop repeats
+//   fuzzIntParam rounds several steps to the same int, so the raw
+//   grid holds identical tuples. Each distinct combo is backtested
+//   once and its result stands for all its duplicates.
+//   Returns the number of redundant combos dropped.
+//-----------------------------------------------
+size_t dedupCombos(std::vector<ParamResult> &combos)
+{
+    auto key = [](const ParamResult &p){
+        return std::make_tuple(p.short_window, p.waiting_period,
+                               p.hs_exit_change_threshold, p.ma_turn_threshold);
+    };
+    std::sort(combos.begin(), combos.end(),
+              [&](const ParamResult &a, const ParamResult &b){ return key(a) < key(b); });
+    auto last = std::unique(combos.begin(), combos.end(),
+              [&](const ParamResult &a, const ParamResult &b){ return key(a) == key(b); });
+    size_t dropped = (size_t)std::distance(last, combos.end());
+    combos.erase(last, combos.end());
+    return dropped;
+}
+
 //-----------------------------------------------
 // Global variables for tracking fuzzer state
 //-----------------------------------------------
 static std::vector<ParamResult> g_combos;
 static std::vector<ParamResult> g_results;
-static std::atomic<size_t> g_nextIdx{0};
 static std::atomic<size_t> g_doneCount{0};
 static size_t g_totalCount = 0;
 
-std::mutex g_resMutex;
+// Kernel the workers run each block through
+enum class FuzzKernel { Scalar, Events, Batch, Simd };
+static FuzzKernel g_kernel = FuzzKernel::Batch;
+static SimdLevel  g_simdLevel = SimdLevel::Scalar;
+
+// How workers claim work
+//   Blocks - PARAM_BLOCK_SIZE combos at a time
+//   Window - one short_window group at a time, sharing its s_avg series
+enum class FuzzSchedule { Blocks, Window };
+static FuzzSchedule g_schedule = FuzzSchedule::Blocks;
+
+// [begin, end) ranges of g_combos sharing a short_window
+struct WindowGroup {
+    size_t begin;
+    size_t end;
+};
+static std::vector<WindowGroup> g_groups;
+
+// Hands out combo ranges (block schedule) or group ranges (window
+// schedule) to the workers of the current run
+static std::unique_ptr<WorkStealingScheduler> g_sched;
+
+// Best results one writer thread has stored, for the progress line.
+// The owner keeps pnl/slot to itself and mirrors the slot indices into
+// shown[] with release stores; those slots are already written and never
+// change again, so the progress thread reads them without a lock. While
+// the owner shifts entries a reader may see a slot twice, which merging
+// drops. Aligned so neighbouring writers do not share a cache line.
+struct alignas(64) WorkerTop {
+    static constexpr int K = 3;
+    double              pnl[K];
+    size_t              slot[K];
+    int                 count = 0;
+    std::atomic<size_t> shown[K];
+    std::atomic<int>    shownCount{0};
+
+    void offer(size_t idx, double v)
+    {
+        if (count == K && v <= pnl[K - 1]) return;
+        int i = count < K ? count++ : K - 1;
+        for (; i > 0 && pnl[i - 1] < v; i--) {
+            pnl[i]  = pnl[i - 1];
+            slot[i] = slot[i - 1];
+        }
+        pnl[i]  = v;
+        slot[i] = idx;
+        for (int k = 0; k < count; k++) {
+            shown[k].store(slot[k], std::memory_order_release);
+        }
+        shownCount.store(count, std::memory_order_release);
+    }
+};
+
+// One WorkerTop per writer thread of the current run
+static std::unique_ptr<WorkerTop[]> g_tops;
+static size_t g_topCapacity = 0;
+static std::atomic<size_t> g_topCount{0};
+
+// Sizes g_results for n combos, written by at most `writers` threads
+static void resetResults(size_t n, unsigned int writers)
+{
+    g_results.assign(n, ParamResult{});
+    g_tops.reset(new WorkerTop[writers]);
+    g_topCapacity = writers;
+    g_topCount = 0;
+}
+
+// Called once by each writer thread before it stores results
+static WorkerTop &claimWorkerTop()
+{
+    size_t w = g_topCount.fetch_add(1);
+    assert(w < g_topCapacity);
+    return g_tops[w];
+}
+
+// Fills slots [start, end) from g_combos and pnl and offers them to top
+static void publishResults(size_t start, size_t end, const double *pnl, WorkerTop &top)
+{
+    for(size_t idx = start; idx < end; idx++){
+        g_results[idx] = g_combos[idx];
+        g_results[idx].pnl = pnl[idx - start];
+        top.offer(idx, pnl[idx - start]);
+    }
+}
+
+// Best n results stored so far, merged from every writer's WorkerTop.
+// Costs O(writers * K) whatever the size of the grid.
+static std::vector<ParamResult> currentTop(int n)
+{
+    std::vector<size_t> slots;
+    size_t writers = g_topCount.load(std::memory_order_acquire);
+    for (size_t w = 0; w < writers; w++) {
+        int count = g_tops[w].shownCount.load(std::memory_order_acquire);
+        for (int k = 0; k < count; k++) {
+            slots.push_back(g_tops[w].shown[k].load(std::memory_order_acquire));
+        }
+    }
+    std::sort(slots.begin(), slots.end());
+    slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+
+    std::vector<ParamResult> out;
+    for (size_t idx : slots) out.push_back(g_results[idx]);
+    std::stable_sort(out.begin(), out.end(),
+                     [](const ParamResult &a, const ParamResult &b){ return a.pnl > b.pnl; });
+    if ((int)out.size() > n) out.resize(n);
+    return out;
+}
 
 //-----------------------------------------------
-// Worker thread function
+// Runs one block through the selected kernel
+//   shortAvg: the block's shared s_avg series, or nullptr; only the
+//   batch and simd kernels use it
 //-----------------------------------------------
-void workerThreadFunc()
+static void runBlock(const ParamBlock &block, double *pnl, const double *shortAvg)
 {
-    while(true){
-        size_t idx = g_nextIdx.fetch_add(1);
-        if(idx >= g_totalCount) {
-            return; // No more combinations to test
+    switch(g_kernel){
+        case FuzzKernel::Scalar:
+            for(int k = 0; k < block.count; k++){
+                pnl[k] = runBacktest(block.short_window[k],
+                                     block.waiting_period[k],
+                                     block.hs_exit_change_threshold[k],
+                                     block.ma_turn_threshold[k],
+                                     g_data);
+            }
+            break;
+        case FuzzKernel::Events:
+            for(int k = 0; k < block.count; k++){
+                pnl[k] = runBacktestEvents(block.short_window[k],
+                                           block.waiting_period[k],
+                                           block.hs_exit_change_threshold[k],
+                                           block.ma_turn_threshold[k],
+                                           g_data);
+            }
+            break;
+        case FuzzKernel::Batch:
+            runBacktestBatch(block, g_data, pnl, shortAvg);
+            break;
+        case FuzzKernel::Simd:
+            runBacktestSimd(block, g_data, pnl, g_simdLevel, shortAvg);
+            break;
+    }
+}
+
+//-----------------------------------------------
+// Runs g_combos[start, end) (at most one block) and stores the results
+//-----------------------------------------------
+static void runRange(size_t start, size_t end, const double *shortAvg, WorkerTop &top)
+{
+    ParamBlock block;
+    double pnl[PARAM_BLOCK_SIZE];
+
+    // Gather parameters for this block
+    for(size_t idx = start; idx < end; idx++){
+        const ParamResult &pr = g_combos[idx];
+        block.add(pr.short_window,
+                  pr.waiting_period,
+                  pr.hs_exit_change_threshold,
+                  pr.ma_turn_threshold);
+    }
+
+    // Run the whole block in one pass
+    runBlock(block, pnl, shortAvg);
+
+    // Store the results
+    publishResults(start, end, pnl, top);
+    g_doneCount.fetch_add(end - start);
+}
+
+//-----------------------------------------------
+// Worker thread functions
+//   Block schedule: claims chunks of whole PARAM_BLOCK_SIZE blocks from
+//   g_sched and runs each block as one batch, so each tick is streamed
+//   once per block
+//-----------------------------------------------
+void workerThreadFunc(unsigned int worker)
+{
+    WorkerTop &top = claimWorkerTop();
+    g_sched->work(worker, [&](size_t begin, size_t end){
+        for(size_t start = begin; start < end; start += PARAM_BLOCK_SIZE){
+            runRange(start, std::min(start + (size_t)PARAM_BLOCK_SIZE, end), nullptr, top);
+        }
+    });
+}
+
+//-----------------------------------------------
+//   Window schedule: claims whole short_window groups, materializes
+//   each group's s_avg series once and runs every block of the group
+//   against it. The series buffer is allocated once per worker and
+//   reused for every group, so there is at most one series per worker.
+//-----------------------------------------------
+void windowWorkerThreadFunc(unsigned int worker)
+{
+    WorkerTop &top = claimWorkerTop();
+    std::vector<double> shortAvg(g_data.size());
+    g_sched->work(worker, [&](size_t first, size_t last){
+        for(size_t g = first; g < last; g++){
+            const WindowGroup &group = g_groups[g];
+            g_data.windowMeans(g_combos[group.begin].short_window, shortAvg.data());
+
+            for(size_t start = group.begin; start < group.end; start += PARAM_BLOCK_SIZE){
+                size_t end = std::min(start + (size_t)PARAM_BLOCK_SIZE, group.end);
+                runRange(start, end, shortAvg.data(), top);
+            }
+        }
+    });
+}
+
+//-----------------------------------------------
+// Scheduler for the current schedule: whole blocks of combos, or
+// short_window groups
+//-----------------------------------------------
+static void resetScheduler(unsigned int hw)
+{
+    WorkStealingScheduler::Options opts;
+    if (g_schedule == FuzzSchedule::Window) {
+        g_sched.reset(new WorkStealingScheduler(g_groups.size(), hw, opts));
+    } else {
+        opts.grain = PARAM_BLOCK_SIZE;
+        g_sched.reset(new WorkStealingScheduler(g_totalCount, hw, opts));
+    }
+}
+
+//-----------------------------------------------
+// Runs g_combos on hw block-schedule workers, without the progress
+// thread, and leaves the PnLs in g_results
+//-----------------------------------------------
+static void runCombosQuiet(unsigned int hw)
+{
+    g_totalCount = g_combos.size();
+    resetResults(g_totalCount, hw);
+    WorkStealingScheduler::Options opts;
+    opts.grain = PARAM_BLOCK_SIZE;
+    g_sched.reset(new WorkStealingScheduler(g_totalCount, hw, opts));
+    g_doneCount = 0;
+
+    std::vector<std::thread> workers;
+    workers.reserve(hw);
+    for(unsigned int i=0; i<hw; i++){
+        workers.emplace_back(workerThreadFunc, i);
+    }
+    for(auto &t : workers){
+        t.join();
+    }
+}
+
+//-----------------------------------------------
+// CMA-ES refinement of the grid's best points
+//   Each seed starts its own CMA-ES in base-relative coordinates
+//   (x = param / base, so sigma 0.03 is 3% of every base). Windows
+//   are rounded when evaluated. Every generation of all seeds runs
+//   as one batch on the worker threads; repeated points come from
+//   a cache instead of being backtested again.
+//-----------------------------------------------
+struct CmaConfig {
+    int    seeds  = 3;     // distinct grid results to start from
+    int    gens   = 40;    // generations per seed at most
+    int    lambda = 16;    // population per generation
+    double sigma  = 0.03;  // initial step, relative to the base values
+};
+
+static ParamResult cmaPoint(const std::vector<double> &x, const double *base)
+{
+    ParamResult pr;
+    pr.short_window             = std::max(1, (int)std::lround(x[0] * base[0]));
+    pr.waiting_period           = std::max(1, (int)std::lround(x[1] * base[1]));
+    pr.hs_exit_change_threshold = std::max(1e-6, x[2] * base[2]);
+    pr.ma_turn_threshold        = std::max(1e-6, x[3] * base[3]);
+    pr.pnl = 0.0;
+    return pr;
+}
+
+static ParamResult runCmaEsStage(const std::vector<ParamResult> &gridResults, const double *base,
+                                 const CmaConfig &cfg, unsigned int hw)
+{
+    using Key = std::tuple<int, int, double, double>;
+    auto key = [](const ParamResult &p){
+        return Key(p.short_window, p.waiting_period, p.hs_exit_change_threshold, p.ma_turn_threshold);
+    };
+
+    std::vector<ParamResult> seeds = gridResults;
+    std::sort(seeds.begin(), seeds.end(), [](auto &a, auto &b){ return a.pnl > b.pnl; });
+    if ((int)seeds.size() > cfg.seeds) seeds.resize(cfg.seeds);
+
+    std::map<Key, double> cache;
+    for (const ParamResult &r : gridResults) cache[key(r)] = r.pnl;
+    ParamResult best = seeds.empty() ? ParamResult{} : seeds.front();
+
+    std::vector<CmaEs> runs;
+    for (size_t k = 0; k < seeds.size(); k++) {
+        std::vector<double> x0 = {seeds[k].short_window / base[0], seeds[k].waiting_period / base[1],
+                                  seeds[k].hs_exit_change_threshold / base[2],
+                                  seeds[k].ma_turn_threshold / base[3]};
+        runs.emplace_back(x0, cfg.sigma, cfg.lambda, 1000 + k);
+    }
+
+    size_t backtests = 0;
+    std::vector<bool> active(runs.size(), true);
+    for (int gen = 0; gen < cfg.gens; gen++) {
+        // One batch for every active seed's generation
+        std::vector<std::vector<std::vector<double>>> pops(runs.size());
+        g_combos.clear();
+        std::map<Key, bool> queued;
+        for (size_t k = 0; k < runs.size(); k++) {
+            if (!active[k]) continue;
+            pops[k] = runs[k].ask();
+            for (const auto &x : pops[k]) {
+                ParamResult pr = cmaPoint(x, base);
+                if (!cache.count(key(pr)) && !queued.count(key(pr))) {
+                    queued[key(pr)] = true;
+                    g_combos.push_back(pr);
+                }
+            }
+        }
+        if (g_combos.empty() && std::none_of(active.begin(), active.end(), [](bool a){ return a; })) {
+            break;
+        }
+        runCombosQuiet(hw);
+        backtests += g_combos.size();
+        for (size_t k = 0; k < g_combos.size(); k++) {
+            cache[key(g_combos[k])] = g_results[k].pnl;
+            if (g_results[k].pnl > best.pnl) best = g_results[k];
+        }
+
+        for (size_t k = 0; k < runs.size(); k++) {
+            if (!active[k]) continue;
+            std::vector<double> scores;
+            for (const auto &x : pops[k]) scores.push_back(cache[key(cmaPoint(x, base))]);
+            runs[k].tell(pops[k], scores);
+            // Converged once the spread is below a tenth of the grid's 1% step
+            if (runs[k].spread() < 1e-3) active[k] = false;
         }
-        
-        // Get parameters for this run
-        ParamResult pr = g_combos[idx];
-
-        // Run backtest with these parameters
-        double pnl = runBacktest(
-            pr.short_window,
-            pr.waiting_period,
-            pr.hs_exit_change_threshold,
-            pr.ma_turn_threshold,
-            g_ticks,
-            g_bids,
-            g_asks
-        );
-        pr.pnl = pnl;
-
-        // Store the result
-        {
-            std::lock_guard<std::mutex> lk(g_resMutex);
-            g_results[idx] = pr;
-        }
-        g_doneCount.fetch_add(1);
     }
+
+    std::cout << "CMA-ES: " << seeds.size() << " seeds, " << backtests << " new backtests. Best => [SW="
+              << best.short_window << ", WP=" << best.waiting_period
+              << ", HSX=" << std::fixed << std::setprecision(4) << best.hs_exit_change_threshold
+              << ", MAT=" << std::fixed << std::setprecision(4) << best.ma_turn_threshold
+              << "] => PnL=" << std::fixed << std::setprecision(2) << best.pnl << std::endl;
+    return best;
 }
 
 //-----------------------------------------------
@@ -115,7 +474,9 @@ void workerThreadFunc()
 void progressThreadFunc()
 {
     using clock = std::chrono::steady_clock;
-    auto nextPrint = clock::now() + std::chrono::seconds(1);
+    auto started   = clock::now();
+    auto nextPrint = started + std::chrono::seconds(1);
+    auto seconds   = [&]{ return std::chrono::duration<double>(clock::now() - started).count(); };
 
     while(true){
         std::this_thread::sleep_until(nextPrint);
@@ -127,32 +488,35 @@ void progressThreadFunc()
             break;
         }
         
-        // Get current results and find top performers
-        std::vector<ParamResult> localCopy;
-        {
-            std::lock_guard<std::mutex> lk(g_resMutex);
-            localCopy = g_results; 
-        }
-        std::sort(localCopy.begin(), localCopy.end(),
-                  [](auto &a, auto &b){
-                      return a.pnl > b.pnl; // Sort descending by PnL
-                  });
+        // Top performers so far, merged from the workers' own top lists
+        std::vector<ParamResult> top = currentTop(3);
+
+        // Throughput over the whole run so far and the time left at that rate
+        double rate = done / std::max(seconds(), 1e-9);
+        long   eta  = rate > 0.0 ? std::lround((g_totalCount - done) / rate) : -1;
 
         // Print progress and top 3 results
         std::cerr << "\r" << std::flush; // Carriage return
         std::cerr << "Progress: " << done << "/" << g_totalCount << " (" 
                   << std::fixed << std::setprecision(1) 
-                  << (100.0 * done / g_totalCount) << "%)  ";
-        
-        int topCount = std::min<int>((int)localCopy.size(), 3);
+                  << (100.0 * done / g_totalCount) << "%)  "
+                  << std::setprecision(0) << rate << " combos/s, ETA ";
+        if (eta >= 0) {
+            std::cerr << eta / 60 << ":" << std::setw(2) << std::setfill('0') << eta % 60 << std::setfill(' ');
+        } else {
+            std::cerr << "--:--";
+        }
+        std::cerr << "  ";
+
+        int topCount = (int)top.size();
         if (topCount > 0) {
             std::cerr << "Top " << topCount << ": ";
             for(int i=0; i<topCount; i++){
-                std::cerr << "[SW=" << localCopy[i].short_window
-                        << ", WP=" << localCopy[i].waiting_period
-                        << ", HSX=" << std::fixed << std::setprecision(3) << localCopy[i].hs_exit_change_threshold
-                        << ", MAT=" << std::fixed << std::setprecision(3) << localCopy[i].ma_turn_threshold
-                        << " => " << std::fixed << std::setprecision(2) << localCopy[i].pnl << "]  ";
+                std::cerr << "[SW=" << top[i].short_window
+                        << ", WP=" << top[i].waiting_period
+                        << ", HSX=" << std::fixed << std::setprecision(3) << top[i].hs_exit_change_threshold
+                        << ", MAT=" << std::fixed << std::setprecision(3) << top[i].ma_turn_threshold
+                        << " => " << std::fixed << std::setprecision(2) << top[i].pnl << "]  ";
             }
         }
         // Erase to end of line
@@ -162,41 +526,776 @@ void progressThreadFunc()
     // Final results
     {
         size_t done = g_doneCount.load();
-        std::vector<ParamResult> localCopy;
-        {
-            std::lock_guard<std::mutex> lk(g_resMutex);
-            localCopy = g_results;
-        }
-        std::sort(localCopy.begin(), localCopy.end(),
-                  [](auto &a, auto &b){
-                      return a.pnl > b.pnl;
-                  });
+        double secs = seconds();
+        std::vector<ParamResult> top = currentTop(3);
 
         std::cerr << "\r" << std::flush;
-        std::cerr << done << "/" << g_totalCount 
-                  << " complete. Final top 3 combinations:\n";
-        int topCount = std::min<int>((int)localCopy.size(), 3);
+        std::cerr << done << "/" << g_totalCount << " complete in "
+                  << std::fixed << std::setprecision(1) << secs << " s ("
+                  << std::setprecision(0) << done / std::max(secs, 1e-9)
+                  << " combos/s). Final top 3 combinations:\x1b[K\n";
+        int topCount = (int)top.size();
         for(int i=0; i<topCount; i++){
-            std::cerr << (i+1) << ") [SW=" << localCopy[i].short_window
-                      << ", WP=" << localCopy[i].waiting_period
-                      << ", HSX=" << std::fixed << std::setprecision(3) << localCopy[i].hs_exit_change_threshold
-                      << ", MAT=" << std::fixed << std::setprecision(3) << localCopy[i].ma_turn_threshold
-                      << "] => PnL=" << std::fixed << std::setprecision(2) << localCopy[i].pnl << "\n";
+            std::cerr << (i+1) << ") [SW=" << top[i].short_window
+                      << ", WP=" << top[i].waiting_period
+                      << ", HSX=" << std::fixed << std::setprecision(3) << top[i].hs_exit_change_threshold
+                      << ", MAT=" << std::fixed << std::setprecision(3) << top[i].ma_turn_threshold
+                      << "] => PnL=" << std::fixed << std::setprecision(2) << top[i].pnl << "\n";
         }
     }
 }
 
+//-----------------------------------------------
+// Genetic search over the four parameters and the strategy's
+// structural switches (StrategyVariant)
+//   Windows are integers; thresholds are kept on a 0.001 lattice so
+//   offspring that land on a known genome hit the fitness cache.
+//   Each generation's uncached genomes run as one batch on hw threads.
+//-----------------------------------------------
+struct GaConfig {
+    int      pop      = 64;    // genomes per generation
+    int      gens     = 50;    // generations
+    int      elite    = 4;     // best genomes copied unchanged
+    double   mutation = 0.2;   // per-gene mutation probability
+    int      range    = 50;    // bounds: ±range% around the base values
+    uint64_t seed     = 1;
+};
+
+struct Genome {
+    int    short_window;
+    int    waiting_period;
+    double hs_exit_change_threshold;
+    double ma_turn_threshold;
+    bool   hold_during_high_spread;
+    int    entry_sides;
+    double pnl;
+};
+
+using GenomeKey = std::tuple<int, int, long, long, bool, int>;
+
+static GenomeKey genomeKey(const Genome &g)
+{
+    return GenomeKey(g.short_window, g.waiting_period,
+                     std::lround(g.hs_exit_change_threshold * 1000.0),
+                     std::lround(g.ma_turn_threshold * 1000.0),
+                     g.hold_during_high_spread, g.entry_sides);
+}
+
+// Backtests genomes[k] for every k in todo on hw threads, handing out
+// genomes through a WorkStealingScheduler like the grid's workers.
+// Returns the scheduler so its utilization can be reported.
+static std::unique_ptr<WorkStealingScheduler> evaluateGenomes(std::vector<Genome> &genomes,
+                                                              const std::vector<size_t> &todo,
+                                                              unsigned int hw)
+{
+    std::unique_ptr<WorkStealingScheduler> sched(new WorkStealingScheduler(todo.size(), hw));
+    auto work = [&](unsigned int worker){
+        sched->work(worker, [&](size_t first, size_t last){
+            for (size_t t = first; t < last; t++) {
+                Genome &g = genomes[todo[t]];
+                StrategyVariant variant;
+                variant.hold_during_high_spread = g.hold_during_high_spread;
+                variant.entry_sides = g.entry_sides;
+                g.pnl = runBacktest(g.short_window, g.waiting_period, g.hs_exit_change_threshold,
+                                    g.ma_turn_threshold, variant, g_data);
+            }
+        });
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(sched->workers());
+    for (unsigned int i = 0; i < sched->workers(); i++) {
+        workers.emplace_back(work, i);
+    }
+    for (auto &t : workers) {
+        t.join();
+    }
+    return sched;
+}
+
+static Genome runGeneticSearch(const double *base, const GaConfig &cfg, unsigned int hw)
+{
+    std::mt19937_64 rng(cfg.seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::normal_distribution<double> normal(0.0, 1.0);
+
+    double lo[4], hi[4];
+    for (int d = 0; d < 4; d++) {
+        lo[d] = base[d] * (1.0 - cfg.range / 100.0);
+        hi[d] = base[d] * (1.0 + cfg.range / 100.0);
+    }
+    lo[0] = std::max(1.0, lo[0]);
+    lo[1] = std::max(1.0, lo[1]);
+    lo[2] = std::max(0.001, lo[2]);
+    lo[3] = std::max(0.001, lo[3]);
+
+    // Clamps the numeric genes into the bounds and onto their lattice
+    auto snap = [&](Genome &g, const double *x){
+        double v[4];
+        for (int d = 0; d < 4; d++) v[d] = std::min(hi[d], std::max(lo[d], x[d]));
+        g.short_window             = (int)std::lround(v[0]);
+        g.waiting_period           = (int)std::lround(v[1]);
+        g.hs_exit_change_threshold = std::lround(v[2] * 1000.0) / 1000.0;
+        g.ma_turn_threshold        = std::lround(v[3] * 1000.0) / 1000.0;
+    };
+    auto randomSides = [&](){ return (int)(rng() % 3) - 1; };
+
+    // The base strategy plus random genomes
+    std::vector<Genome> pop;
+    Genome first{};
+    snap(first, base);
+    pop.push_back(first);
+    while ((int)pop.size() < cfg.pop) {
+        Genome g{};
+        double x[4];
+        for (int d = 0; d < 4; d++) x[d] = lo[d] + unit(rng) * (hi[d] - lo[d]);
+        snap(g, x);
+        g.hold_during_high_spread = unit(rng) < 0.5;
+        g.entry_sides = randomSides();
+        pop.push_back(g);
+    }
+
+    std::map<GenomeKey, double> cache;
+    size_t backtests = 0, cacheHits = 0;
+    std::unique_ptr<WorkStealingScheduler> busiest;   // generation with the most backtests
+    size_t busiestSize = 0;
+    Genome best{};
+    best.pnl = -std::numeric_limits<double>::infinity();
+    auto higher = [](const Genome &a, const Genome &b){ return a.pnl > b.pnl; };
+
+    for (int gen = 0; gen < cfg.gens; gen++) {
+        // Fitness from the cache where known; the rest is one batch
+        std::vector<size_t> todo;
+        std::map<GenomeKey, bool> queued;
+        for (size_t k = 0; k < pop.size(); k++) {
+            GenomeKey key = genomeKey(pop[k]);
+            if (cache.count(key)) {
+                cacheHits++;
+            }
+            else if (!queued.count(key)) {
+                queued[key] = true;
+                todo.push_back(k);
+            }
+        }
+        std::unique_ptr<WorkStealingScheduler> sched = evaluateGenomes(pop, todo, hw);
+        if (todo.size() > busiestSize) {
+            busiestSize = todo.size();
+            busiest = std::move(sched);
+        }
+        backtests += todo.size();
+        for (size_t k : todo) {
+            cache[genomeKey(pop[k])] = pop[k].pnl;
+        }
+        for (Genome &g : pop) {
+            g.pnl = cache[genomeKey(g)];
+        }
+
+        std::stable_sort(pop.begin(), pop.end(), higher);
+        if (pop.front().pnl > best.pnl) best = pop.front();
+        std::cout << "  gen " << gen << ": " << todo.size() << " new backtests, best PnL "
+                  << std::fixed << std::setprecision(2) << best.pnl << std::endl;
+        if (gen + 1 == cfg.gens) {
+            break;
+        }
+
+        // Next generation: the elites unchanged, then children of
+        // 3-way tournament winners by uniform crossover and mutation
+        auto tournament = [&]() -> const Genome & {
+            size_t pick = rng() % pop.size();
+            for (int t = 1; t < 3; t++) pick = std::min<size_t>(pick, rng() % pop.size());
+            return pop[pick];   // pop is sorted, so the lowest index is the fittest
+        };
+        std::vector<Genome> next(pop.begin(), pop.begin() + std::min(cfg.elite, (int)pop.size()));
+        while ((int)next.size() < cfg.pop) {
+            const Genome &a = tournament();
+            const Genome &b = tournament();
+            double xa[4] = {(double)a.short_window, (double)a.waiting_period,
+                            a.hs_exit_change_threshold, a.ma_turn_threshold};
+            double xb[4] = {(double)b.short_window, (double)b.waiting_period,
+                            b.hs_exit_change_threshold, b.ma_turn_threshold};
+            double x[4];
+            for (int d = 0; d < 4; d++) {
+                x[d] = unit(rng) < 0.5 ? xa[d] : xb[d];
+                if (unit(rng) < cfg.mutation) {
+                    x[d] += normal(rng) * 0.1 * (hi[d] - lo[d]);
+                }
+            }
+            Genome child{};
+            snap(child, x);
+            child.hold_during_high_spread = unit(rng) < 0.5 ? a.hold_during_high_spread
+                                                            : b.hold_during_high_spread;
+            child.entry_sides = unit(rng) < 0.5 ? a.entry_sides : b.entry_sides;
+            if (unit(rng) < cfg.mutation) child.hold_during_high_spread = !child.hold_during_high_spread;
+            if (unit(rng) < cfg.mutation) child.entry_sides = randomSides();
+            next.push_back(child);
+        }
+        pop.swap(next);
+    }
+
+    if (busiest) {
+        std::cout << "GA generation with the most backtests (" << busiestSize << "):\n";
+        busiest->report(std::cout);
+    }
+    std::cout << "GA: " << cfg.gens << " generations of " << cfg.pop << ", " << backtests
+              << " backtests, " << cacheHits << " fitness cache hits. Best => [SW="
+              << best.short_window << ", WP=" << best.waiting_period
+              << ", HSX=" << std::fixed << std::setprecision(3) << best.hs_exit_change_threshold
+              << ", MAT=" << std::fixed << std::setprecision(3) << best.ma_turn_threshold
+              << ", hold=" << (best.hold_during_high_spread ? "yes" : "no")
+              << ", sides=" << (best.entry_sides > 0 ? "long" : best.entry_sides < 0 ? "short" : "both")
+              << "] => PnL=" << std::fixed << std::setprecision(2) << best.pnl << std::endl;
+    return best;
+}
+
+//-----------------------------------------------
+// Neighbourhood robustness of the dense grid
+//   Lays the results out as a tensor over the distinct values of each
+//   axis and scores every point by the mean and the minimum PnL over
+//   its ±k-step box (GridFilter: one sliding pass per axis), so a lone
+//   spike among weak neighbours stands out next to a broad plateau.
+//   fuzzIntParam rounds several 1% steps to the same window, so the
+//   axes are deduplicated first: a step is one distinct value, and no
+//   combo is counted twice in a box.
+//-----------------------------------------------
+static void reportRobustness(std::vector<int> sw_vals, std::vector<int> wp_vals,
+                             std::vector<double> hsx_vals, std::vector<double> mat_vals,
+                             int k)
+{
+    // Axes come sorted from fuzzIntParam / fuzzDoubleParam
+    sw_vals.erase(std::unique(sw_vals.begin(), sw_vals.end()), sw_vals.end());
+    wp_vals.erase(std::unique(wp_vals.begin(), wp_vals.end()), wp_vals.end());
+    hsx_vals.erase(std::unique(hsx_vals.begin(), hsx_vals.end()), hsx_vals.end());
+    mat_vals.erase(std::unique(mat_vals.begin(), mat_vals.end()), mat_vals.end());
+
+    auto key = [](const ParamResult &p){
+        return std::make_tuple(p.short_window, p.waiting_period,
+                               p.hs_exit_change_threshold, p.ma_turn_threshold);
+    };
+    std::vector<int> dims = {(int)sw_vals.size(), (int)wp_vals.size(),
+                             (int)hsx_vals.size(), (int)mat_vals.size()};
+    std::vector<double> pnl;
+    std::vector<size_t> combo;   // tensor point -> index in g_results
+    pnl.reserve((size_t)dims[0] * dims[1] * dims[2] * dims[3]);
+    for (int sw : sw_vals)
+    for (int wp : wp_vals)
+    for (double hsx : hsx_vals)
+    for (double mat : mat_vals) {
+        ParamResult probe{sw, wp, hsx, mat, 0.0};
+        // g_results follows g_combos, which dedupCombos left sorted
+        auto it = std::lower_bound(g_results.begin(), g_results.end(), probe,
+                                   [&](const ParamResult &a, const ParamResult &b){ return key(a) < key(b); });
+        if (it == g_results.end() || key(*it) != key(probe)) {
+            std::cout << "Robustness: skipped, the results do not cover the full grid\n";
+            return;
+        }
+        pnl.push_back(it->pnl);
+        combo.push_back((size_t)(it - g_results.begin()));
+    }
+
+    std::vector<double> mean = GridFilter::boxMean(pnl, dims, k);
+    std::vector<double> low  = GridFilter::boxMin(pnl, dims, k);
+
+    // Best tensor point per distinct combo, ranked by score
+    auto top = [&](const std::vector<double> &score, int n){
+        std::vector<size_t> order(pnl.size());
+        for (size_t i = 0; i < order.size(); i++) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b){ return score[a] > score[b]; });
+        std::vector<size_t> out;
+        std::set<size_t> seen;
+        for (size_t i = 0; i < order.size() && (int)out.size() < n; i++) {
+            if (seen.insert(combo[order[i]]).second) out.push_back(order[i]);
+        }
+        return out;
+    };
+    auto print = [&](const std::vector<size_t> &points){
+        for (size_t i = 0; i < points.size(); i++) {
+            const ParamResult &r = g_results[combo[points[i]]];
+            std::cout << (i+1) << ") [SW=" << r.short_window
+                      << ", WP=" << r.waiting_period
+                      << ", HSX=" << std::fixed << std::setprecision(3) << r.hs_exit_change_threshold
+                      << ", MAT=" << std::fixed << std::setprecision(3) << r.ma_turn_threshold
+                      << "] => PnL=" << std::fixed << std::setprecision(2) << r.pnl
+                      << ", ±" << k << " mean=" << mean[points[i]] << ", min=" << low[points[i]] << "\n";
+        }
+    };
+    std::cout << "Robustness over each point's ±" << k << "-step neighbourhood ("
+              << pnl.size() << " grid points, " << dims[0] << "x" << dims[1] << "x"
+              << dims[2] << "x" << dims[3] << "; one step = one distinct value)\n";
+    std::cout << "Top 3 by PnL:\n";
+    print(top(pnl, 3));
+    std::cout << "Top 3 by neighbourhood mean:\n";
+    print(top(mean, 3));
+    std::cout << "Top 3 by neighbourhood min:\n";
+    print(top(low, 3));
+    std::cout << std::flush;
+}
+
+//-----------------------------------------------
+// Distributed sweep over SweepProtocol.h
+//   The coordinator owns g_combos and leases them out in ranges of
+//   leaseSize. Each worker process gets up to two leases at a time (so
+//   the next is queued while it computes), runs each one with
+//   runCombosQuiet() and streams back one Result per lease. The leases
+//   of a worker whose connection drops, or of one that has not answered
+//   within leaseTimeout seconds, go back to the queue. A worker that
+//   let a lease expire gets no new ones until it answers again, and a
+//   result for a lease already finished elsewhere is ignored.
+//-----------------------------------------------
+static uint64_t dataFingerprint()
+{
+    uint64_t h = 1469598103934665603ull;
+    auto mix = [&h](const void *p, size_t n){
+        const unsigned char *b = static_cast<const unsigned char *>(p);
+        for (size_t i = 0; i < n; i++) {
+            h ^= b[i];
+            h *= 1099511628211ull;
+        }
+    };
+    mix(g_ticks.data(), g_ticks.size() * sizeof(int));
+    mix(g_bids.data(), g_bids.size() * sizeof(double));
+    mix(g_asks.data(), g_asks.size() * sizeof(double));
+    return h;
+}
+
+struct SweepLease {
+    size_t begin;
+    size_t end;
+    int    state = 0;    // 0 queued, 1 leased, 2 done
+    int    owner = -1;   // worker id while leased
+    uint64_t sent  = 0;  // send order, to find a worker's oldest lease
+    std::chrono::steady_clock::time_point deadline{};  // max() until the worker starts it
+
+    SweepLease(size_t b, size_t e) : begin(b), end(e) {}
+};
+
+struct SweepPeer {
+    int                           id;
+    std::unique_ptr<SweepChannel> channel;
+    bool                          ready = false;
+    bool                          stalled = false;  // let a lease expire; no more until it answers
+    std::set<size_t>              leases;
+    size_t                        results = 0;
+
+    SweepPeer(int i, std::unique_ptr<SweepChannel> c) : id(i), channel(std::move(c)) {}
+};
+
+static void runCoordinator(int listenFd, size_t leaseSize, int leaseTimeout)
+{
+    using clock = std::chrono::steady_clock;
+    const uint64_t fingerprint = dataFingerprint();
+    WorkerTop &top = claimWorkerTop();
+
+    std::vector<SweepLease> leases;
+    std::deque<size_t> queue;
+    for (size_t b = 0; b < g_totalCount; b += leaseSize) {
+        queue.push_back(leases.size());
+        leases.emplace_back(b, std::min(b + leaseSize, g_totalCount));
+    }
+    size_t leasesDone = 0, releases = 0;
+    uint64_t sends = 0;
+    int nextId = 0;
+    std::vector<SweepPeer> peers;
+
+    // The worker runs its leases in the order they were sent, so only the
+    // oldest outstanding one is in progress. Its clock starts when it gets
+    // to the front; a lease queued behind it has no deadline yet.
+    auto startNextLease = [&](SweepPeer &peer){
+        for (size_t l : peer.leases) {
+            if (leases[l].deadline != clock::time_point::max()) return;
+        }
+        if (!peer.leases.empty()) {
+            size_t next = *peer.leases.begin();
+            for (size_t l : peer.leases) {
+                if (leases[l].sent < leases[next].sent) next = l;
+            }
+            leases[next].deadline = clock::now() + std::chrono::seconds(leaseTimeout);
+        }
+    };
+
+    // Puts the leases still held by peers[k] back in front of the queue
+    auto dropPeer = [&](size_t k, const char *why){
+        for (size_t l : peers[k].leases) {
+            if (leases[l].state == 1 && leases[l].owner == peers[k].id) {
+                leases[l].state = 0;
+                leases[l].owner = -1;
+                queue.push_front(l);
+                releases++;
+            }
+        }
+        std::cerr << "\r\x1b[KCoordinator: worker " << peers[k].id << " " << why << " after "
+                  << peers[k].results << " leases, " << peers[k].leases.size() << " re-queued" << std::endl;
+        peers.erase(peers.begin() + k);
+    };
+
+    while (leasesDone < leases.size()) {
+        std::vector<pollfd> fds{{listenFd, POLLIN, 0}};
+        for (const SweepPeer &p : peers) {
+            fds.push_back({p.channel->fd(), POLLIN, 0});
+        }
+        ::poll(fds.data(), fds.size(), 1000);
+
+        if (fds[0].revents & POLLIN) {
+            int fd = ::accept(listenFd, nullptr, nullptr);
+            if (fd >= 0) {
+                peers.emplace_back(nextId++, std::unique_ptr<SweepChannel>(new SweepChannel(fd)));
+            }
+        }
+
+        // Peers were polled in order; walk backwards so dropping is safe
+        for (size_t k = fds.size() - 1; k >= 1; k--) {
+            size_t pi = k - 1;
+            if (!(fds[k].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            SweepPeer &peer = peers[pi];
+            bool alive = peer.channel->fill();
+            SweepMsg type;
+            std::string payload;
+            while (alive && peer.channel->next(type, payload)) {
+                SweepReader in(payload);
+                if (type == SweepMsg::Hello) {
+                    uint32_t magic   = in.get<uint32_t>();
+                    uint64_t fp      = in.get<uint64_t>();
+                    uint32_t threads = in.get<uint32_t>();
+                    if (!in.ok() || magic != SWEEP_PROTOCOL_MAGIC || fp != fingerprint) {
+                        peer.channel->send(SweepMsg::Reject, "protocol or data file mismatch");
+                        alive = false;
+                        break;
+                    }
+                    peer.ready = true;
+                    std::cerr << "\r\x1b[KCoordinator: worker " << peer.id << " joined with "
+                              << threads << " threads" << std::endl;
+                }
+                else if (type == SweepMsg::Result) {
+                    uint64_t l     = in.get<uint64_t>();
+                    uint32_t count = in.get<uint32_t>();
+                    if (!in.ok() || l >= leases.size() || count != leases[l].end - leases[l].begin) {
+                        alive = false;
+                        break;
+                    }
+                    peer.leases.erase(l);
+                    peer.results++;
+                    peer.stalled = false;
+                    startNextLease(peer);
+                    if (leases[l].state == 2) continue;   // finished elsewhere after a timeout
+                    std::vector<double> pnl(count);
+                    for (double &v : pnl) v = in.get<double>();
+                    if (!in.ok()) {
+                        alive = false;
+                        break;
+                    }
+                    publishResults(leases[l].begin, leases[l].end, pnl.data(), top);
+                    leases[l].state = 2;
+                    leasesDone++;
+                    g_doneCount += count;
+                }
+                else {
+                    alive = false;
+                }
+            }
+            if (!alive || peer.channel->broken()) {
+                dropPeer(pi, "disconnected");
+            }
+        }
+
+        // Re-queue the leases of a live but stuck worker: once the lease it
+        // is running passes its deadline, the one queued behind it goes too
+        auto now = clock::now();
+        for (SweepPeer &peer : peers) {
+            bool expired = false;
+            for (size_t l : peer.leases) {
+                expired |= leases[l].state == 1 && now > leases[l].deadline;
+            }
+            if (!expired) continue;
+            for (size_t l : peer.leases) {
+                if (leases[l].state == 1 && leases[l].owner == peer.id) {
+                    leases[l].state = 0;
+                    leases[l].owner = -1;
+                    queue.push_front(l);
+                    releases++;
+                }
+            }
+            peer.leases.clear();
+            peer.stalled = true;
+        }
+
+        // Keep two leases outstanding per ready, responsive worker
+        for (size_t k = 0; k < peers.size(); k++) {
+            SweepPeer &peer = peers[k];
+            bool alive = true;
+            while (alive && peer.ready && !peer.stalled && peer.leases.size() < 2 && !queue.empty()) {
+                size_t l = queue.front();
+                queue.pop_front();
+                if (leases[l].state != 0) continue;
+                SweepWriter out;
+                out.put<uint64_t>(l).put<uint32_t>((uint32_t)(leases[l].end - leases[l].begin));
+                for (size_t i = leases[l].begin; i < leases[l].end; i++) {
+                    out.put<int32_t>(g_combos[i].short_window).put<int32_t>(g_combos[i].waiting_period)
+                       .put<double>(g_combos[i].hs_exit_change_threshold).put<double>(g_combos[i].ma_turn_threshold);
+                }
+                leases[l].state    = 1;
+                leases[l].owner    = peer.id;
+                leases[l].sent     = ++sends;
+                leases[l].deadline = clock::time_point::max();
+                peer.leases.insert(l);
+                startNextLease(peer);
+                alive = peer.channel->send(SweepMsg::Lease, out.bytes());
+            }
+            if (!alive) {
+                dropPeer(k--, "disconnected");
+            }
+        }
+    }
+
+    for (SweepPeer &peer : peers) {
+        peer.channel->send(SweepMsg::Done);
+    }
+    ::close(listenFd);
+    std::cerr << "\r\x1b[KCoordinator: " << leases.size() << " leases done, " << releases
+              << " re-leased" << std::endl;
+}
+
+// Worker process: connects (retrying for up to 30 s while the coordinator
+// starts), then runs leases on hw threads until told the sweep is done
+static int runSweepWorker(const std::string &addr, unsigned int hw)
+{
+    std::string error;
+    int fd = -1;
+    for (int attempt = 0; attempt < 300 && fd < 0; attempt++) {
+        fd = sweepSocket(addr, false, error);
+        if (fd < 0) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    if (fd < 0) {
+        std::cerr << "Error: " << error << std::endl;
+        return 1;
+    }
+    SweepChannel channel(fd);
+    channel.send(SweepMsg::Hello, SweepWriter().put<uint32_t>(SWEEP_PROTOCOL_MAGIC)
+                                               .put<uint64_t>(dataFingerprint())
+                                               .put<uint32_t>(hw).bytes());
+
+    size_t leaseCount = 0, comboCount = 0;
+    SweepMsg type;
+    std::string payload;
+    while (channel.receive(type, payload)) {
+        if (type == SweepMsg::Done) {
+            std::cout << "Worker: sweep done, ran " << leaseCount << " leases (" << comboCount
+                      << " combos)" << std::endl;
+            return 0;
+        }
+        if (type == SweepMsg::Reject) {
+            std::cerr << "Error: coordinator rejected this worker: " << payload << std::endl;
+            return 1;
+        }
+        if (type != SweepMsg::Lease) continue;
+
+        SweepReader in(payload);
+        uint64_t l     = in.get<uint64_t>();
+        uint32_t count = in.get<uint32_t>();
+        g_combos.clear();
+        for (uint32_t k = 0; k < count; k++) {
+            ParamResult pr;
+            pr.short_window             = in.get<int32_t>();
+            pr.waiting_period           = in.get<int32_t>();
+            pr.hs_exit_change_threshold = in.get<double>();
+            pr.ma_turn_threshold        = in.get<double>();
+            pr.pnl = 0.0;
+            g_combos.push_back(pr);
+        }
+        if (!in.ok()) {
+            std::cerr << "Error: malformed lease" << std::endl;
+            return 1;
+        }
+        runCombosQuiet(hw);
+
+        SweepWriter out;
+        out.put<uint64_t>(l).put<uint32_t>(count);
+        for (uint32_t k = 0; k < count; k++) {
+            out.put<double>(g_results[k].pnl);
+        }
+        if (!channel.send(SweepMsg::Result, out.bytes())) break;
+        leaseCount++;
+        comboCount += count;
+    }
+    std::cerr << "Error: lost the coordinator after " << leaseCount << " leases" << std::endl;
+    return 1;
+}
+
 //-----------------------------------------------
 // Main function
+//   fuzzer [csv] [--kernel scalar|events|batch|simd|avx2|avx512] [--span N]
+//          [--schedule blocks|window]
+//          [--refine [--refine-range R] [--refine-keep K] [--compare-dense]]
+//          [--shard i/N] [--out FILE] [--threads T] [--robust-k K]
+//          [--coordinator ADDR [--lease N] [--lease-timeout SEC] | --worker ADDR]
+//          [--ga [--ga-pop P] [--ga-gens G] [--ga-elite E] [--ga-mut M]
+//                [--ga-range R] [--ga-seed S]]
 //-----------------------------------------------
 int main(int argc, char* argv[])
 {
     // Default CSV file path
     std::string csvPath = "../data/UEC.csv";
-    
+    int span = 10;
+    bool refine = false;
+    bool compareDense = false;
+    RefineConfig refineCfg;
+    bool sample = false;
+    SampleMethod sampleMethod = SampleMethod::Sobol;
+    uint64_t sampleCount = 4096;
+    uint64_t sampleSeed = 1;
+    int shardIndex = 0;
+    int shardCount = 1;
+    std::string outPath;
+    std::string coordinatorAddr;
+    std::string workerAddr;
+    size_t leaseSize = 1024;
+    int leaseTimeout = 300;
+    unsigned int threads = 0;
+    int robustK = 1;
+    bool cmaes = false;
+    CmaConfig cmaCfg;
+    bool ga = false;
+    GaConfig gaCfg;
+    g_simdLevel = bestSimdLevel();
+
     // Parse command line arguments
-    if (argc > 1) {
-        csvPath = argv[1];
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--kernel" && i + 1 < argc) {
+            std::string k = argv[++i];
+            if (k == "scalar")      g_kernel = FuzzKernel::Scalar;
+            else if (k == "events") g_kernel = FuzzKernel::Events;
+            else if (k == "batch")  g_kernel = FuzzKernel::Batch;
+            else if (k == "simd")   g_kernel = FuzzKernel::Simd;
+            else if (k == "avx2")   { g_kernel = FuzzKernel::Simd; g_simdLevel = SimdLevel::AVX2; }
+            else if (k == "avx512") { g_kernel = FuzzKernel::Simd; g_simdLevel = SimdLevel::AVX512; }
+            else {
+                std::cerr << "Error: unknown kernel " << k << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--schedule" && i + 1 < argc) {
+            std::string sched = argv[++i];
+            if (sched == "blocks")      g_schedule = FuzzSchedule::Blocks;
+            else if (sched == "window") g_schedule = FuzzSchedule::Window;
+            else {
+                std::cerr << "Error: unknown schedule " << sched << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--refine") {
+            refine = true;
+        }
+        else if (arg == "--refine-range" && i + 1 < argc) {
+            refineCfg.range = std::stoi(argv[++i]);
+            if (refineCfg.range < 1 || refineCfg.range > 99) {
+                std::cerr << "Error: --refine-range must be in [1, 99]" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--refine-keep" && i + 1 < argc) {
+            refineCfg.keepBest = refineCfg.keepStable = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--compare-dense") {
+            compareDense = true;
+        }
+        else if (arg == "--sample" && i + 1 < argc) {
+            std::string method = argv[++i];
+            if (!ParamSampler::parseMethod(method, sampleMethod)) {
+                std::cerr << "Error: unknown sampling method " << method << std::endl;
+                return 1;
+            }
+            sample = true;
+        }
+        else if (arg == "--samples" && i + 1 < argc) {
+            sampleCount = std::stoull(argv[++i]);
+        }
+        else if (arg == "--seed" && i + 1 < argc) {
+            sampleSeed = std::stoull(argv[++i]);
+        }
+        else if (arg == "--shard" && i + 1 < argc) {
+            std::string sh = argv[++i];
+            size_t slash = sh.find('/');
+            if (slash != std::string::npos) {
+                shardIndex = std::stoi(sh.substr(0, slash));
+                shardCount = std::stoi(sh.substr(slash + 1));
+            }
+            if (slash == std::string::npos || shardCount < 1 || shardIndex < 0 || shardIndex >= shardCount) {
+                std::cerr << "Error: --shard expects i/N with 0 <= i < N" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--out" && i + 1 < argc) {
+            outPath = argv[++i];
+        }
+        else if (arg == "--robust-k" && i + 1 < argc) {
+            robustK = std::max(0, std::stoi(argv[++i]));
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            threads = (unsigned int)std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--coordinator" && i + 1 < argc) {
+            coordinatorAddr = argv[++i];
+        }
+        else if (arg == "--worker" && i + 1 < argc) {
+            workerAddr = argv[++i];
+        }
+        else if (arg == "--lease" && i + 1 < argc) {
+            leaseSize = (size_t)std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--lease-timeout" && i + 1 < argc) {
+            leaseTimeout = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--cmaes") {
+            cmaes = true;
+        }
+        else if (arg == "--cmaes-seeds" && i + 1 < argc) {
+            cmaCfg.seeds = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--cmaes-gens" && i + 1 < argc) {
+            cmaCfg.gens = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--cmaes-lambda" && i + 1 < argc) {
+            cmaCfg.lambda = std::max(4, std::stoi(argv[++i]));
+        }
+        else if (arg == "--cmaes-sigma" && i + 1 < argc) {
+            cmaCfg.sigma = std::stod(argv[++i]);
+        }
+        else if (arg == "--ga") {
+            ga = true;
+        }
+        else if (arg == "--ga-pop" && i + 1 < argc) {
+            gaCfg.pop = std::max(2, std::stoi(argv[++i]));
+        }
+        else if (arg == "--ga-gens" && i + 1 < argc) {
+            gaCfg.gens = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--ga-elite" && i + 1 < argc) {
+            gaCfg.elite = std::max(0, std::stoi(argv[++i]));
+        }
+        else if (arg == "--ga-mut" && i + 1 < argc) {
+            gaCfg.mutation = std::stod(argv[++i]);
+        }
+        else if (arg == "--ga-range" && i + 1 < argc) {
+            gaCfg.range = std::stoi(argv[++i]);
+            if (gaCfg.range < 0 || gaCfg.range > 99) {
+                std::cerr << "Error: --ga-range must be in [0, 99]" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--ga-seed" && i + 1 < argc) {
+            gaCfg.seed = std::stoull(argv[++i]);
+        }
+        else if (arg == "--span" && i + 1 < argc) {
+            span = std::stoi(argv[++i]);
+            if (span < 0 || span > 99) {
+                std::cerr << "Error: --span must be in [0, 99]" << std::endl;
+                return 1;
+            }
+        }
+        else {
+            csvPath = arg;
+        }
+    }
+    if (g_simdLevel > bestSimdLevel()) {
+        g_simdLevel = bestSimdLevel();
     }
     
     std::cout << "Loading data from: " << csvPath << std::endl;
@@ -217,8 +1316,8 @@ int main(int argc, char* argv[])
             // Skip header if present
             if(first_line){
                 first_line = false;
-                // Uncomment next line if there's no header
-                // continue; 
+                // Comment out next line if there's no header
+                continue;
             }
             
             std::stringstream ss(line);
@@ -245,51 +1344,192 @@ int main(int argc, char* argv[])
     }
     std::cout << "Loaded " << g_nrows << " rows from " << csvPath << std::endl;
 
+    // Precompute mid, spread, high-spread mask and mid prefix sums once
+    g_data = PreparedDataset(g_ticks, g_bids, g_asks);
+
     // 2) Define base parameter values and create combinations
     int    baseSW  = 80;
     int    baseWP  = 80;
     double baseHSX = 0.2;
     double baseMAT = 0.9;
 
-    auto sw_vals  = fuzzIntParam(baseSW);
-    auto wp_vals  = fuzzIntParam(baseWP);
-    auto hsx_vals = fuzzDoubleParam(baseHSX);
-    auto mat_vals = fuzzDoubleParam(baseMAT);
-
-    // Build all parameter combinations
-    for(int sw : sw_vals){
-        for(int wp : wp_vals){
-            for(double hsx : hsx_vals){
-                for(double mat : mat_vals){
-                    ParamResult pr;
-                    pr.short_window = sw;
-                    pr.waiting_period = wp;
-                    pr.hs_exit_change_threshold = hsx;
-                    pr.ma_turn_threshold = mat;
-                    pr.pnl = 0.0;
-                    g_combos.push_back(pr);
+    unsigned int hw = std::thread::hardware_concurrency();
+    if(hw == 0) hw = 2; // Fallback if hardware_concurrency fails
+    if(threads > 0) hw = threads;
+
+    // Worker process of a distributed sweep: the coordinator sends the combos
+    if (!workerAddr.empty()) {
+        return runSweepWorker(workerAddr, hw);
+    }
+
+    // Genetic search over a wider box and the structural switches,
+    // instead of the grid
+    if (ga) {
+        std::cout << "Genetic search over ±" << gaCfg.range << "% and the structural switches, using "
+                  << hw << " threads..." << std::endl;
+        const double base[4] = {(double)baseSW, (double)baseWP, baseHSX, baseMAT};
+        auto start = std::chrono::steady_clock::now();
+        runGeneticSearch(base, gaCfg, hw);
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "GA took " << std::fixed << std::setprecision(1) << secs << " s" << std::endl;
+        return 0;
+    }
+
+    // Coarse-to-fine refinement instead of (or before) the dense grid
+    RefinePoint refined{};
+    size_t refineCount = 0;
+    if (refine) {
+        std::cout << "Refining over ±" << refineCfg.range << "% from a "
+                  << refineCfg.coarseStep << "% lattice down to 1%, using "
+                  << hw << " threads..." << std::endl;
+
+        GridRefiner refiner(refineCfg, [&](const GridRefiner::Offsets &k){
+            return RefinePoint{fuzzIntStep(baseSW, k[0]), fuzzIntStep(baseWP, k[1]),
+                               fuzzDoubleStep(baseHSX, k[2]), fuzzDoubleStep(baseMAT, k[3]), 0.0};
+        });
+        auto evalBatch = [&](std::vector<RefinePoint> &batch){
+            g_combos.clear();
+            for (const RefinePoint &p : batch) {
+                g_combos.push_back({p.short_window, p.waiting_period,
+                                    p.hs_exit_change_threshold, p.ma_turn_threshold, 0.0});
+            }
+            runCombosQuiet(hw);
+            for (size_t k = 0; k < batch.size(); k++) {
+                batch[k].pnl = g_results[k].pnl;
+            }
+        };
+
+        RefinePoint best = refiner.run(evalBatch, &std::cout);
+        refined     = refiner.best(span);
+        refineCount = refiner.evaluations();
+
+        std::cout << "Refinement used " << refineCount << " backtests. Best => [SW="
+                  << best.short_window << ", WP=" << best.waiting_period
+                  << ", HSX=" << std::fixed << std::setprecision(3) << best.hs_exit_change_threshold
+                  << ", MAT=" << std::fixed << std::setprecision(3) << best.ma_turn_threshold
+                  << "] => PnL=" << std::fixed << std::setprecision(2) << best.pnl << std::endl;
+        std::cout << "Best within the ±" << span << "% dense range => PnL="
+                  << std::fixed << std::setprecision(2) << refined.pnl << std::endl;
+
+        if (!compareDense) {
+            return 0;
+        }
+        g_combos.clear();
+    }
+
+    auto sw_vals  = fuzzIntParam(baseSW, span);
+    auto wp_vals  = fuzzIntParam(baseWP, span);
+    auto hsx_vals = fuzzDoubleParam(baseHSX, span);
+    auto mat_vals = fuzzDoubleParam(baseMAT, span);
+
+    // Fixed-budget sample over the same ±span% box instead of the grid.
+    // Every point is a pure function of its index, so --shard i/N runs
+    // slice i of the same sample and the N slices add up to all of it.
+    if (sample) {
+        ParamSampler sampler({{(double)sw_vals.front(), (double)sw_vals.back(), true},
+                              {(double)wp_vals.front(), (double)wp_vals.back(), true},
+                              {hsx_vals.front(), hsx_vals.back(), false},
+                              {mat_vals.front(), mat_vals.back(), false}},
+                             sampleMethod, sampleSeed, sampleCount);
+        auto range = ParamSampler::shard(sampleCount, shardIndex, shardCount);
+        for (uint64_t k = range.first; k < range.second; k++) {
+            std::vector<double> x = sampler.point(k);
+            g_combos.push_back({(int)x[0], (int)x[1], x[2], x[3], 0.0});
+        }
+        std::cout << "Sampling " << (sampleMethod == SampleMethod::Sobol ? "Sobol" : "Latin hypercube")
+                  << " points " << range.first << "-" << range.second << " of " << sampleCount
+                  << " (seed " << sampleSeed << ", shard " << shardIndex << "/" << shardCount << ")"
+                  << std::endl;
+    }
+    else {
+        // Build all parameter combinations
+        for(int sw : sw_vals){
+            for(int wp : wp_vals){
+                for(double hsx : hsx_vals){
+                    for(double mat : mat_vals){
+                        ParamResult pr;
+                        pr.short_window = sw;
+                        pr.waiting_period = wp;
+                        pr.hs_exit_change_threshold = hsx;
+                        pr.ma_turn_threshold = mat;
+                        pr.pnl = 0.0;
+                        g_combos.push_back(pr);
+                    }
                 }
             }
         }
     }
+    size_t gridCount = g_combos.size();
+    size_t redundant = dedupCombos(g_combos);
+
+    // The deduplicated grid is sorted, so --shard i/N keeps slice i of the
+    // same order in every process
+    uint64_t sweepTotal = sample ? sampleCount : g_combos.size();
+    if (!sample && shardCount > 1) {
+        auto range = ParamSampler::shard(g_combos.size(), shardIndex, shardCount);
+        g_combos = std::vector<ParamResult>(g_combos.begin() + range.first, g_combos.begin() + range.second);
+        std::cout << "Grid shard " << shardIndex << "/" << shardCount << ": combos " << range.first
+                  << "-" << range.second << " of " << sweepTotal << std::endl;
+    }
+    if (outPath.empty() && shardCount > 1) {
+        outPath = "fuzz_shard_" + std::to_string(shardIndex) + "_of_" + std::to_string(shardCount) + ".part";
+    }
     g_totalCount = g_combos.size();
-    g_results.resize(g_totalCount);
+    resetResults(g_totalCount, hw);
+
+    // Split the combos into short_window groups for the window schedule
+    // (dedupCombos leaves them sorted by short_window first)
+    if (g_schedule == FuzzSchedule::Window) {
+        for (size_t idx = 0; idx < g_totalCount; idx++) {
+            if (idx == 0 || g_combos[idx].short_window != g_combos[idx - 1].short_window) {
+                g_groups.push_back({idx, idx});
+            }
+            g_groups.back().end = idx + 1;
+        }
+        std::cout << "Scheduling " << g_groups.size() << " short_window groups." << std::endl;
+    }
 
-    std::cout << "Testing " << g_totalCount << " parameter combinations..." << std::endl;
+    std::cout << "Testing " << g_totalCount << " parameter combinations ("
+              << gridCount << (sample ? " sample points, " : " grid points, ") << redundant
+              << " redundant backtests skipped)..." << std::endl;
 
     // 3) Multi-threading setup
-    unsigned int hw = std::thread::hardware_concurrency();
-    if(hw == 0) hw = 2; // Fallback if hardware_concurrency fails
-    std::cout << "Using " << hw << " threads." << std::endl;
+    g_doneCount = 0;
+    int listenFd = -1;
+    if (!coordinatorAddr.empty()) {
+        std::string error;
+        listenFd = sweepSocket(coordinatorAddr, true, error);
+        if (listenFd < 0) {
+            std::cerr << "Error: " << error << std::endl;
+            return 1;
+        }
+        std::cout << "Coordinating on " << coordinatorAddr << ": leases of " << leaseSize
+                  << " combos, re-leased after " << leaseTimeout << " s without a result" << std::endl;
+    }
+    std::cout << "Using " << hw << " threads, kernel: "
+              << (g_kernel == FuzzKernel::Scalar ? "scalar" :
+                  g_kernel == FuzzKernel::Events ? "events" :
+                  g_kernel == FuzzKernel::Batch  ? "batch"  : simdLevelName(g_simdLevel))
+              << std::endl;
 
     // Start progress reporting thread
     std::thread progThread(progressThreadFunc);
 
-    // Spawn worker threads
+    // Spawn worker threads, or hand the combos to worker processes
     std::vector<std::thread> workers;
-    workers.reserve(hw);
-    for(unsigned int i=0; i<hw; i++){
-        workers.emplace_back(workerThreadFunc);
+    if (listenFd >= 0) {
+        runCoordinator(listenFd, leaseSize, leaseTimeout);
+    }
+    else {
+        resetScheduler(hw);
+        workers.reserve(hw);
+        for(unsigned int i=0; i<hw; i++){
+            if (g_schedule == FuzzSchedule::Window) {
+                workers.emplace_back(windowWorkerThreadFunc, i);
+            } else {
+                workers.emplace_back(workerThreadFunc, i);
+            }
+        }
     }
 
     // Wait for worker threads to complete
@@ -299,6 +1539,74 @@ int main(int argc, char* argv[])
 
     // Wait for progress thread to finish final report
     progThread.join();
+    if (listenFd < 0) {
+        g_sched->report(std::cout);
+    }
+
+    // Rank the full grid by neighbourhood as well (samples and shards
+    // have no dense tensor)
+    if (robustK > 0 && !sample && shardCount == 1) {
+        reportRobustness(sw_vals, wp_vals, hsx_vals, mat_vals, robustK);
+    }
+
+    // Partial results for fuzz-merge. The sweep string pins down the combo
+    // space, so only files from the same sweep can be merged.
+    if (!outPath.empty()) {
+        std::ostringstream sweep;
+        sweep << (sample ? (sampleMethod == SampleMethod::Sobol ? "sobol" : "lhs") : "grid")
+              << " span=" << span << " base=" << baseSW << "," << baseWP << "," << baseHSX << "," << baseMAT;
+        if (sample) {
+            sweep << " samples=" << sampleCount << " seed=" << sampleSeed;
+        }
+        sweep << " data=" << csvPath.substr(csvPath.find_last_of('/') + 1) << " rows=" << g_nrows;
+
+        PartialHeader header;
+        header.sweep       = sweep.str();
+        header.shard_index = (uint32_t)shardIndex;
+        header.shard_count = (uint32_t)shardCount;
+        header.total       = sweepTotal;
+        std::vector<PartialRecord> records;
+        records.reserve(g_results.size());
+        for (const ParamResult &r : g_results) {
+            records.push_back({r.short_window, r.waiting_period, r.hs_exit_change_threshold,
+                               r.ma_turn_threshold, r.pnl});
+        }
+        if (!PartialResults::write(outPath, header, records)) {
+            std::cerr << "Error: cannot write " << outPath << std::endl;
+            return 1;
+        }
+        std::cout << "Wrote " << records.size() << " results to " << outPath << std::endl;
+    }
+
+    // Compare the refinement against the dense grid it replaces
+    if (refine) {
+        double denseBest = -std::numeric_limits<double>::infinity();
+        for (const ParamResult &r : g_results) {
+            denseBest = std::max(denseBest, r.pnl);
+        }
+        std::cout << "Refinement: " << refineCount << " backtests vs " << g_totalCount
+                  << " for the dense ±" << span << "% grid ("
+                  << std::fixed << std::setprecision(1) << (100.0 * refineCount / g_totalCount)
+                  << "%). Dense optimum PnL=" << std::setprecision(2) << denseBest
+                  << ", refined PnL in that range=" << refined.pnl
+                  << (refined.pnl == denseBest ? " (same optimum)" : " (different optimum)")
+                  << std::endl;
+    }
+
+    // Continue from the grid's best points with CMA-ES
+    if (cmaes) {
+        std::vector<ParamResult> gridResults = g_results;
+        double gridBest = -std::numeric_limits<double>::infinity();
+        for (const ParamResult &r : gridResults) {
+            gridBest = std::max(gridBest, r.pnl);
+        }
+        const double base[4] = {(double)baseSW, (double)baseWP, baseHSX, baseMAT};
+        auto start = std::chrono::steady_clock::now();
+        ParamResult best = runCmaEsStage(gridResults, base, cmaCfg, hw);
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "CMA-ES took " << std::fixed << std::setprecision(1) << secs << " s: PnL "
+                  << std::setprecision(2) << gridBest << " (grid) -> " << best.pnl << std::endl;
+    }
 
     return 0;
 } 
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "../include/PartialResults.h"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <tuple>
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+//-----------------------------------------------
+// Merges fuzzer partial-results files (fuzzer --shard i/N --out FILE)
+// into one ranking with summary statistics
+//   fuzz-merge [--top N] [--csv FILE] part...
+//
+// Every file must come from the same sweep with the same shard count.
+// Missing shards are reported and the rest is merged anyway. A parameter
+// set present in several files (overlapping sample shards, or the same
+// shard given twice) is counted once.
+//-----------------------------------------------
+int main(int argc, char* argv[])
+{
+    int topN = 10;
+    std::string csvPath;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--top" && i + 1 < argc) {
+            topN = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--csv" && i + 1 < argc) {
+            csvPath = argv[++i];
+        }
+        else {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.empty()) {
+        std::cerr << "Usage: fuzz-merge [--top N] [--csv FILE] part..." << std::endl;
+        return 1;
+    }
+
+    // 1) Read and check every partial file
+    PartialHeader first;
+    std::set<uint32_t> shards;
+    std::map<std::tuple<int, int, double, double>, double> merged;
+    size_t records = 0;
+    for (size_t f = 0; f < inputs.size(); f++) {
+        PartialHeader header;
+        std::vector<PartialRecord> part;
+        std::string error;
+        if (!PartialResults::read(inputs[f], header, part, error)) {
+            std::cerr << "Error: " << inputs[f] << ": " << error << std::endl;
+            return 1;
+        }
+        if (f == 0) {
+            first = header;
+        }
+        else if (header.sweep != first.sweep || header.shard_count != first.shard_count) {
+            std::cerr << "Error: " << inputs[f] << " (" << header.sweep << ", "
+                      << header.shard_count << " shards) does not match " << inputs[0] << " ("
+                      << first.sweep << ", " << first.shard_count << " shards)" << std::endl;
+            return 1;
+        }
+        if (!shards.insert(header.shard_index).second) {
+            std::cerr << "Warning: shard " << header.shard_index << " given more than once" << std::endl;
+        }
+        for (const PartialRecord &r : part) {
+            merged[std::make_tuple(r.short_window, r.waiting_period,
+                                   r.hs_exit_change_threshold, r.ma_turn_threshold)] = r.pnl;
+        }
+        records += part.size();
+    }
+
+    std::cout << "Sweep: " << first.sweep << std::endl;
+    std::cout << "Shards: " << shards.size() << "/" << first.shard_count << " present";
+    if (shards.size() < first.shard_count) {
+        std::cout << ", missing:";
+        for (uint32_t s = 0; s < first.shard_count; s++) {
+            if (!shards.count(s)) std::cout << " " << s;
+        }
+    }
+    std::cout << std::endl;
+
+    // 2) Global ranking, highest PnL first
+    std::vector<PartialRecord> ranking;
+    ranking.reserve(merged.size());
+    for (const auto &kv : merged) {
+        ranking.push_back({std::get<0>(kv.first), std::get<1>(kv.first),
+                           std::get<2>(kv.first), std::get<3>(kv.first), kv.second});
+    }
+    std::stable_sort(ranking.begin(), ranking.end(),
+                     [](const PartialRecord &a, const PartialRecord &b){ return a.pnl > b.pnl; });
+    std::cout << "Results: " << records << " records, " << ranking.size()
+              << " distinct parameter sets (sweep total " << first.total << ")" << std::endl;
+    if (ranking.empty()) {
+        return 0;
+    }
+
+    // 3) Summary statistics of the PnL distribution
+    double sum = 0.0;
+    size_t profitable = 0;
+    for (const PartialRecord &r : ranking) {
+        sum += r.pnl;
+        if (r.pnl > 0.0) profitable++;
+    }
+    double mean = sum / ranking.size();
+    double var = 0.0;
+    for (const PartialRecord &r : ranking) {
+        var += (r.pnl - mean) * (r.pnl - mean);
+    }
+    size_t n = ranking.size();
+    double median = (n % 2) ? ranking[n / 2].pnl : 0.5 * (ranking[n / 2 - 1].pnl + ranking[n / 2].pnl);
+    std::cout << std::fixed << std::setprecision(2)
+              << "PnL: best " << ranking.front().pnl << ", worst " << ranking.back().pnl
+              << ", mean " << mean << ", median " << median
+              << ", stddev " << std::sqrt(var / n)
+              << ", profitable " << profitable << " (" << std::setprecision(1)
+              << (100.0 * profitable / n) << "%)" << std::endl;
+
+    int topCount = std::min<int>(topN, (int)n);
+    std::cout << "Top " << topCount << " combinations:\n";
+    for (int i = 0; i < topCount; i++) {
+        std::cout << (i+1) << ") [SW=" << ranking[i].short_window
+                  << ", WP=" << ranking[i].waiting_period
+                  << ", HSX=" << std::fixed << std::setprecision(3) << ranking[i].hs_exit_change_threshold
+                  << ", MAT=" << std::fixed << std::setprecision(3) << ranking[i].ma_turn_threshold
+                  << "] => PnL=" << std::fixed << std::setprecision(2) << ranking[i].pnl << "\n";
+    }
+
+    // 4) Full ranking as CSV
+    if (!csvPath.empty()) {
+        std::ofstream out(csvPath);
+        if (!out) {
+            std::cerr << "Error: cannot write " << csvPath << std::endl;
+            return 1;
+        }
+        out << "short_window,waiting_period,hs_exit_change_threshold,ma_turn_threshold,pnl\n";
+        out << std::setprecision(17);
+        for (const PartialRecord &r : ranking) {
+            out << r.short_window << "," << r.waiting_period << "," << r.hs_exit_change_threshold
+                << "," << r.ma_turn_threshold << "," << r.pnl << "\n";
+        }
+        std::cout << "Wrote the full ranking to " << csvPath << std::endl;
+    }
+
+    return 0;
+}
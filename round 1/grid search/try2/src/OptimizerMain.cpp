@@ -0,0 +1,590 @@
+#include "../include/Backtester.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <set>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <tuple>
+#include <cmath>
+#include <chrono>
+#include <iomanip>
+#include <limits>
+
+//-----------------------------------------------
+// Global variables for CSV data
+//-----------------------------------------------
+static std::vector<int>    g_ticks;
+static std::vector<double> g_bids;
+static std::vector<double> g_asks;
+
+//-----------------------------------------------
+// One strategy configuration and its result
+//   hs_threshold and position_size default to the strategy's
+//   built-in 1.3 and 100.
+//-----------------------------------------------
+struct Trial {
+    std::vector<double> unit;   // coordinates in [0, 1]^D
+    int    short_window   = 0;
+    int    waiting_period = 0;
+    double hs_exit_change_threshold = 0.0;
+    double ma_turn_threshold        = 0.0;
+    double hs_threshold   = 1.3;
+    int    position_size  = 100;
+    double pnl = 0.0;
+};
+
+using TrialKey = std::tuple<int, int, double, double, double, int>;
+
+static TrialKey trialKey(const Trial &t)
+{
+    return TrialKey(t.short_window, t.waiting_period, t.hs_exit_change_threshold,
+                    t.ma_turn_threshold, t.hs_threshold, t.position_size);
+}
+
+//-----------------------------------------------
+// Search space
+//   Every dimension is searched in unit coordinates. A dimension
+//   maps u in [0, 1] to lo + u * (hi - lo), snapped to `step`
+//   (0 = continuous), and `apply` stores that value in a Trial.
+//-----------------------------------------------
+struct Dimension {
+    std::string name;
+    double lo;
+    double hi;
+    double step;
+    std::function<void(Trial &, double)> apply;
+
+    double value(double u) const
+    {
+        double v = lo + u * (hi - lo);
+        if (step > 0.0) {
+            v = lo + std::round((v - lo) / step) * step;
+        }
+        return std::min(hi, std::max(lo, v));
+    }
+    double unit(double v) const { return hi > lo ? (v - lo) / (hi - lo) : 0.5; }
+};
+
+// Same mapping as the fuzzer's grid: an offset of i% from the base
+static int gridInt(int baseVal, int i)
+{
+    double factor = (100.0 + i)/100.0;
+    int iv = (int)std::round(baseVal * factor);
+    return iv < 1 ? 1 : iv;
+}
+
+static double gridDouble(double baseVal, int i)
+{
+    double factor = (100.0 + i)/100.0;
+    double dv = baseVal * factor;
+    return dv <= 0.0 ? 1e-6 : dv;
+}
+
+// "grid": the fuzzer's ±span% lattice over the four tunable parameters,
+// so the optimum can be checked against a dense fuzzer run
+static std::vector<Dimension> gridSpace(int span)
+{
+    double s = span;
+    return {
+        {"SW",  -s, s, 1.0, [](Trial &t, double v){ t.short_window = gridInt(80, (int)v); }},
+        {"WP",  -s, s, 1.0, [](Trial &t, double v){ t.waiting_period = gridInt(80, (int)v); }},
+        {"HSX", -s, s, 1.0, [](Trial &t, double v){ t.hs_exit_change_threshold = gridDouble(0.2, (int)v); }},
+        {"MAT", -s, s, 1.0, [](Trial &t, double v){ t.ma_turn_threshold = gridDouble(0.9, (int)v); }},
+    };
+}
+
+// "wide": far beyond the grid, also freeing the high-spread threshold and
+// the order size. LONG_WINDOW only feeds the plotted long average, never
+// a decision, so searching it would only waste evaluations.
+static std::vector<Dimension> wideSpace()
+{
+    return {
+        {"SW",   10,  400,  1.0,  [](Trial &t, double v){ t.short_window = (int)v; }},
+        {"WP",   10,  400,  1.0,  [](Trial &t, double v){ t.waiting_period = (int)v; }},
+        {"HSX",  0.01, 1.5, 0.0,  [](Trial &t, double v){ t.hs_exit_change_threshold = v; }},
+        {"MAT",  0.05, 3.0, 0.0,  [](Trial &t, double v){ t.ma_turn_threshold = v; }},
+        {"HST",  0.8,  2.5, 0.05, [](Trial &t, double v){ t.hs_threshold = v; }},
+        {"SIZE", 10,   100, 10.0, [](Trial &t, double v){ t.position_size = (int)v; }},
+    };
+}
+
+// Snaps unit coordinates onto the space and fills in the parameters
+static Trial makeTrial(const std::vector<Dimension> &space, std::vector<double> unit)
+{
+    Trial t;
+    for (size_t d = 0; d < space.size(); d++) {
+        double v = space[d].value(unit[d]);
+        unit[d] = space[d].unit(v);
+        space[d].apply(t, v);
+    }
+    t.unit = std::move(unit);
+    return t;
+}
+
+//-----------------------------------------------
+// Multivariate Parzen estimator on [0, 1]^D
+//   A flat prior plus one product of truncated Gaussians per
+//   observation. Bandwidths follow Scott's rule on the observations'
+//   spread, so they shrink as the observations concentrate, but never
+//   fall below half a lattice step.
+//-----------------------------------------------
+class ParzenEstimator {
+public:
+    ParzenEstimator(const std::vector<std::vector<double>> &points,
+                    const std::vector<double> &minSigma)
+        : mus_(points), sigma_(minSigma.size())
+    {
+        size_t D = minSigma.size();
+        double n = (double)points.size();
+        double scott = std::pow(std::max(1.0, n), -1.0 / (D + 4.0));
+        for (size_t d = 0; d < D; d++) {
+            double mean = 0.0, var = 0.0;
+            for (const auto &p : points) mean += p[d];
+            mean /= std::max(1.0, n);
+            for (const auto &p : points) var += (p[d] - mean) * (p[d] - mean);
+            double sd = n > 1 ? std::sqrt(var / (n - 1)) : 0.5;
+            sigma_[d] = std::min(1.0, std::max(minSigma[d], 1.06 * sd * scott));
+        }
+        for (size_t d = 0; d < D; d++) {
+            logNorm_.push_back(std::log(sigma_[d] * std::sqrt(2.0 * M_PI)));
+        }
+    }
+
+    // Draws from a random component (index mus_.size() is the prior)
+    std::vector<double> sample(std::mt19937_64 &rng) const
+    {
+        std::uniform_real_distribution<double> uni(0.0, 1.0);
+        size_t k = std::uniform_int_distribution<size_t>(0, mus_.size())(rng);
+        std::vector<double> u(sigma_.size());
+        for (size_t d = 0; d < u.size(); d++) {
+            if (k == mus_.size()) {
+                u[d] = uni(rng);
+                continue;
+            }
+            std::normal_distribution<double> g(mus_[k][d], sigma_[d]);
+            double x = g(rng);
+            for (int tries = 0; tries < 16 && (x < 0.0 || x > 1.0); tries++) {
+                x = g(rng);
+            }
+            u[d] = std::min(1.0, std::max(0.0, x));
+        }
+        return u;
+    }
+
+    double logPdf(const std::vector<double> &u) const
+    {
+        // The prior is uniform on the unit cube: log density 0
+        std::vector<double> terms(1, 0.0);
+        for (const auto &mu : mus_) {
+            double lp = 0.0;
+            for (size_t d = 0; d < u.size(); d++) {
+                double z = (u[d] - mu[d]) / sigma_[d];
+                double mass = 0.5 * (std::erfc(-(1.0 - mu[d]) / (sigma_[d] * M_SQRT2))
+                                   - std::erfc(mu[d] / (sigma_[d] * M_SQRT2)));
+                lp += -0.5 * z * z - logNorm_[d] - std::log(std::max(mass, 1e-300));
+            }
+            terms.push_back(lp);
+        }
+        double top = *std::max_element(terms.begin(), terms.end());
+        double sum = 0.0;
+        for (double t : terms) sum += std::exp(t - top);
+        return top + std::log(sum / terms.size());
+    }
+
+private:
+    std::vector<std::vector<double>> mus_;
+    std::vector<double>              sigma_;
+    std::vector<double>              logNorm_;
+};
+
+//-----------------------------------------------
+// Tree-structured Parzen Estimator
+//   Splits the finished trials into the best gamma fraction l(x)
+//   and the rest g(x), draws candidates from l(x) and proposes the
+//   one maximizing l(x) / g(x). Trials still running count as bad
+//   observations ("constant liar"), which pushes concurrent
+//   suggestions apart instead of piling them onto one point.
+//-----------------------------------------------
+struct TpeConfig {
+    int    startup    = 64;    // random trials before the model kicks in
+    double gamma      = 0.10;  // fraction of trials modelled as good
+    int    maxGood    = 25;    // cap on the good set
+    int    maxBad     = 256;   // g(x) uses a random subset of this many
+    int    candidates = 32;    // draws from l(x) per suggestion
+};
+
+class TpeSampler {
+public:
+    TpeSampler(const std::vector<Dimension> &space, const TpeConfig &cfg, uint64_t seed)
+        : space_(space), cfg_(cfg), rng_(seed)
+    {
+        for (const Dimension &dim : space_) {
+            double width = dim.hi - dim.lo;
+            minSigma_.push_back(dim.step > 0.0 && width > 0.0 ? 0.5 * dim.step / width : 0.005);
+        }
+    }
+
+    // Next trial to run; never one already finished or pending
+    Trial suggest(const std::vector<Trial> &done, const std::vector<Trial> &pending,
+                  const std::set<TrialKey> &seen)
+    {
+        if ((int)done.size() < cfg_.startup) {
+            return randomTrial(seen);
+        }
+
+        // Split by PnL
+        std::vector<size_t> order(done.size());
+        for (size_t k = 0; k < order.size(); k++) order[k] = k;
+        std::sort(order.begin(), order.end(),
+                  [&](size_t a, size_t b){ return done[a].pnl > done[b].pnl; });
+        size_t nGood = (size_t)std::ceil(cfg_.gamma * done.size());
+        nGood = std::max<size_t>(1, std::min<size_t>(nGood, cfg_.maxGood));
+
+        std::vector<std::vector<double>> good, bad;
+        for (size_t k = 0; k < nGood; k++) {
+            good.push_back(done[order[k]].unit);
+        }
+        std::vector<size_t> rest(order.begin() + nGood, order.end());
+        if ((int)rest.size() > cfg_.maxBad) {
+            std::shuffle(rest.begin(), rest.end(), rng_);
+            rest.resize(cfg_.maxBad);
+        }
+        for (size_t k : rest) {
+            bad.push_back(done[k].unit);
+        }
+        for (const Trial &t : pending) {
+            bad.push_back(t.unit);
+        }
+
+        ParzenEstimator l(good, minSigma_);
+        ParzenEstimator g(bad, minSigma_);
+
+        // Score candidates; take the best one not run yet
+        std::vector<std::pair<double, Trial>> scored;
+        for (int c = 0; c < cfg_.candidates; c++) {
+            Trial t = makeTrial(space_, l.sample(rng_));
+            scored.push_back({l.logPdf(t.unit) - g.logPdf(t.unit), std::move(t)});
+        }
+        std::sort(scored.begin(), scored.end(),
+                  [](const std::pair<double, Trial> &a, const std::pair<double, Trial> &b){
+                      return a.first > b.first;
+                  });
+        for (auto &s : scored) {
+            if (!seen.count(trialKey(s.second))) {
+                return std::move(s.second);
+            }
+        }
+        return randomTrial(seen);
+    }
+
+private:
+    Trial randomTrial(const std::set<TrialKey> &seen)
+    {
+        std::uniform_real_distribution<double> uni(0.0, 1.0);
+        Trial t;
+        for (int tries = 0; tries < 64; tries++) {
+            std::vector<double> u(space_.size());
+            for (double &x : u) x = uni(rng_);
+            t = makeTrial(space_, u);
+            if (!seen.count(trialKey(t))) {
+                break;
+            }
+        }
+        return t;
+    }
+
+    const std::vector<Dimension> &space_;
+    TpeConfig                     cfg_;
+    std::mt19937_64               rng_;
+    std::vector<double>           minSigma_;
+};
+
+//-----------------------------------------------
+// Prepared datasets, one per high-spread threshold, built on
+// first use and shared read-only by the workers
+//-----------------------------------------------
+static std::map<long long, std::unique_ptr<PreparedDataset>> g_datasets;
+static std::mutex g_datasetMutex;
+
+static const PreparedDataset &datasetFor(double hs_threshold)
+{
+    std::lock_guard<std::mutex> lk(g_datasetMutex);
+    auto &slot = g_datasets[std::llround(hs_threshold * 1e6)];
+    if (!slot) {
+        slot.reset(new PreparedDataset(g_ticks, g_bids, g_asks, hs_threshold));
+    }
+    return *slot;
+}
+
+//-----------------------------------------------
+// Asynchronous evaluation queue
+//   The main thread keeps up to g_queueDepth trials queued or
+//   running, so a worker that finishes always finds the next trial
+//   waiting; suggestions are made while the workers backtest.
+//-----------------------------------------------
+static std::deque<Trial>       g_jobs;
+static std::vector<Trial>      g_finished;
+static bool                    g_stop = false;
+static std::mutex              g_queueMutex;
+static std::condition_variable g_jobReady;
+static std::condition_variable g_resultReady;
+
+static void workerThreadFunc()
+{
+    while (true) {
+        Trial t;
+        {
+            std::unique_lock<std::mutex> lk(g_queueMutex);
+            g_jobReady.wait(lk, []{ return g_stop || !g_jobs.empty(); });
+            if (g_jobs.empty()) {
+                return;
+            }
+            t = std::move(g_jobs.front());
+            g_jobs.pop_front();
+        }
+
+        t.pnl = runBacktest(t.short_window, t.waiting_period, t.hs_exit_change_threshold,
+                            t.ma_turn_threshold, t.position_size, datasetFor(t.hs_threshold));
+
+        {
+            std::lock_guard<std::mutex> lk(g_queueMutex);
+            g_finished.push_back(std::move(t));
+        }
+        g_resultReady.notify_one();
+    }
+}
+
+static void printTrial(const Trial &t)
+{
+    std::cout << "[SW=" << t.short_window << ", WP=" << t.waiting_period
+              << ", HSX=" << std::fixed << std::setprecision(4) << t.hs_exit_change_threshold
+              << ", MAT=" << std::fixed << std::setprecision(4) << t.ma_turn_threshold
+              << ", HST=" << std::fixed << std::setprecision(2) << t.hs_threshold
+              << ", SIZE=" << t.position_size
+              << "] => PnL=" << std::fixed << std::setprecision(2) << t.pnl;
+}
+
+//-----------------------------------------------
+// main()
+//-----------------------------------------------
+int main(int argc, char* argv[])
+{
+    std::string csvPath = "../data/UEC.csv";
+    std::string spaceName = "wide";
+    int span = 10;
+    int budget = 2000;
+    uint64_t seed = 1;
+    unsigned int hw = std::thread::hardware_concurrency();
+    if (hw == 0) hw = 2; // Fallback if hardware_concurrency fails
+    double target = std::numeric_limits<double>::quiet_NaN();
+    TpeConfig cfg;
+
+    // Parse command line arguments
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--space" && i + 1 < argc) {
+            spaceName = argv[++i];
+            if (spaceName != "grid" && spaceName != "wide") {
+                std::cerr << "Error: unknown space " << spaceName << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--span" && i + 1 < argc) {
+            span = std::stoi(argv[++i]);
+            if (span < 1 || span > 99) {
+                std::cerr << "Error: --span must be in [1, 99]" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--budget" && i + 1 < argc) {
+            budget = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--startup" && i + 1 < argc) {
+            cfg.startup = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::stoull(argv[++i]);
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            hw = (unsigned int)std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--target" && i + 1 < argc) {
+            target = std::stod(argv[++i]);
+        }
+        else {
+            csvPath = arg;
+        }
+    }
+
+    std::cout << "Loading data from: " << csvPath << std::endl;
+
+    // 1) Read CSV data
+    {
+        std::ifstream fin(csvPath);
+        if(!fin.is_open()){
+            std::cerr << "Error: cannot open " << csvPath << std::endl;
+            return 1;
+        }
+
+        bool first_line = true;
+        std::string line;
+        while(std::getline(fin, line)){
+            if(line.empty()) continue;
+
+            // Skip header
+            if(first_line){
+                first_line = false;
+                continue;
+            }
+
+            std::stringstream ss(line);
+            std::string c1, c2, c3;
+            if(std::getline(ss, c1, ',') &&
+               std::getline(ss, c2, ',') &&
+               std::getline(ss, c3, ','))
+            {
+                g_ticks.push_back(std::stoi(c1));
+                g_bids.push_back(std::stod(c2));
+                g_asks.push_back(std::stod(c3));
+            }
+        }
+    }
+    if(g_ticks.empty()){
+        std::cerr << "Error: No data loaded from " << csvPath << std::endl;
+        return 1;
+    }
+    std::cout << "Loaded " << g_ticks.size() << " rows from " << csvPath << std::endl;
+
+    // 2) Search space and sampler
+    std::vector<Dimension> space = (spaceName == "grid") ? gridSpace(span) : wideSpace();
+    double spacePoints = 1.0;
+    for (const Dimension &dim : space) {
+        spacePoints = dim.step > 0.0 ? spacePoints * (std::round((dim.hi - dim.lo) / dim.step) + 1)
+                                     : std::numeric_limits<double>::infinity();
+    }
+    if (spacePoints < budget) {
+        budget = (int)spacePoints;
+    }
+    TpeSampler sampler(space, cfg, seed);
+
+    std::cout << "TPE over the " << spaceName << " space (" << space.size() << " dimensions";
+    if (std::isfinite(spacePoints)) {
+        std::cout << ", " << (long long)spacePoints << " lattice points";
+    }
+    std::cout << "), budget " << budget << " backtests, " << hw << " threads" << std::endl;
+
+    // 3) Asynchronous optimization loop
+    const size_t queueDepth = 2 * (size_t)hw;
+    std::vector<Trial> done;
+    std::vector<Trial> pending;
+    std::set<TrialKey> seen;
+    Trial best;
+    best.pnl = -std::numeric_limits<double>::infinity();
+    int bestAt = 0;
+    int targetAt = 0;
+    int issued = 0;
+    int reportEvery = std::max(1, budget / 10);
+
+    auto startTime = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < hw; i++) {
+        workers.emplace_back(workerThreadFunc);
+    }
+
+    while ((int)done.size() < budget && !(targetAt > 0)) {
+        // Top up the queue with fresh suggestions
+        while (pending.size() < queueDepth && issued < budget) {
+            Trial t = sampler.suggest(done, pending, seen);
+            if (!seen.insert(trialKey(t)).second) {
+                // Lattice exhausted around the model; stop issuing
+                budget = issued;
+                break;
+            }
+            pending.push_back(t);
+            issued++;
+            {
+                std::lock_guard<std::mutex> lk(g_queueMutex);
+                g_jobs.push_back(std::move(t));
+            }
+            g_jobReady.notify_one();
+        }
+        if (pending.empty()) {
+            break;
+        }
+
+        // Collect whatever finished
+        std::vector<Trial> finished;
+        {
+            std::unique_lock<std::mutex> lk(g_queueMutex);
+            g_resultReady.wait(lk, []{ return !g_finished.empty(); });
+            finished.swap(g_finished);
+        }
+        for (Trial &t : finished) {
+            TrialKey key = trialKey(t);
+            pending.erase(std::find_if(pending.begin(), pending.end(),
+                          [&](const Trial &p){ return trialKey(p) == key; }));
+            done.push_back(std::move(t));
+            const Trial &r = done.back();
+            if (r.pnl > best.pnl) {
+                best = r;
+                bestAt = (int)done.size();
+            }
+            if (targetAt == 0 && !std::isnan(target) && r.pnl >= target) {
+                targetAt = (int)done.size();
+            }
+            if (done.size() % reportEvery == 0) {
+                double secs = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - startTime).count();
+                std::cout << "  " << done.size() << " backtests, "
+                          << std::fixed << std::setprecision(0) << done.size() / secs
+                          << "/s, best ";
+                printTrial(best);
+                std::cout << std::endl;
+            }
+        }
+    }
+
+    // Drain: let running trials finish, then stop the workers
+    {
+        std::lock_guard<std::mutex> lk(g_queueMutex);
+        g_jobs.clear();
+        g_stop = true;
+    }
+    g_jobReady.notify_all();
+    for (auto &t : workers) {
+        t.join();
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    // 4) Report
+    std::cout << "\nBest after " << done.size() << " backtests ("
+              << std::fixed << std::setprecision(1) << secs << " s, found at backtest "
+              << bestAt << "):\n  ";
+    printTrial(best);
+    std::cout << std::endl;
+    if (std::isfinite(spacePoints)) {
+        std::cout << "Evaluated " << std::fixed << std::setprecision(2)
+                  << 100.0 * done.size() / spacePoints << "% of the lattice" << std::endl;
+    }
+    if (!std::isnan(target)) {
+        if (targetAt > 0) {
+            std::cout << "Reached target PnL " << std::fixed << std::setprecision(2) << target
+                      << " at backtest " << targetAt << std::endl;
+        } else {
+            std::cout << "Target PnL " << std::fixed << std::setprecision(2) << target
+                      << " not reached" << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+#include "../include/PreparedDataset.h"
+#include "Strategy.h"
+
+// ---------------------------------------------------------
+// PreparedDataset construction
+// ---------------------------------------------------------
+PreparedDataset::PreparedDataset(const std::vector<int>    &ticks_in,
+                                 const std::vector<double> &bids,
+                                 const std::vector<double> &asks)
+    : PreparedDataset(ticks_in, bids, asks, HIGH_SPREAD_THRESHOLD)
+{
+}
+
+PreparedDataset::PreparedDataset(const std::vector<int>    &ticks_in,
+                                 const std::vector<double> &bids,
+                                 const std::vector<double> &asks,
+                                 double                     threshold)
+    : ticks(ticks_in),
+      bid(bids.begin(), bids.end()),
+      ask(asks.begin(), asks.end()),
+      hs_threshold(threshold)
+{
+    int n = (int)ticks.size();
+    mid.resize(n);
+    spread.resize(n);
+    hs_mask.assign((n + 63) / 64, 0);
+    mid_prefix.resize(n + 1);
+
+    double running = 0.0;
+    mid_prefix[0] = 0.0;
+    for(int i = 0; i < n; i++) {
+        double m = 0.5 * (bid[i] + ask[i]);
+        double spr = ask[i] - bid[i];
+        mid[i] = m;
+        spread[i] = spr;
+        if(spr >= hs_threshold) {
+            hs_mask[i >> 6] |= (uint64_t)1 << (i & 63);
+        }
+        running += m;
+        mid_prefix[i + 1] = running;
+
+        // High-spread run boundaries
+        bool hs = spr >= hs_threshold;
+        bool prev = (i > 0) && highSpread(i - 1);
+        if(hs && !prev) {
+            hs_entries.push_back(i);
+        }
+        else if(!hs && prev) {
+            hs_exits.push_back(i);
+        }
+    }
+}
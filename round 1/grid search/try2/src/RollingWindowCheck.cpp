@@ -0,0 +1,1002 @@
+#include "../include/Backtester.h"
+#include "../include/PreparedDataset.h"
+
+// Every header try1/main.cpp and try3/param_search_optimized.cpp include,
+// pulled in at global scope first so including those files inside a
+// namespace below adds only their own definitions
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <queue>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <functional>
+#include <tuple>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <iomanip>
+#include <cstdio>
+#include <cstdint>
+#include "../include/RollingWindow.h"
+#include "../include/ParamSampler.h"
+#include "../include/GridRefiner.h"
+#include "../include/TopK.h"
+#include "../include/WorkStealing.h"
+
+//-----------------------------------------------
+// Current try1 and try3 kernels: the program sources themselves, each
+// in its own namespace with main renamed, so the check runs exactly
+// the code those binaries are built from
+//-----------------------------------------------
+#define main try1_main
+namespace try1 {
+#include "../../try1/main.cpp"
+}
+#undef main
+
+#define main try3_main
+namespace try3 {
+#include "../../try3/param_search_optimized.cpp"
+}
+#undef main
+
+//-----------------------------------------------
+// Baselines: each tree's backtest as it was before the rolling
+// averages were streamed, copied unchanged (history vectors,
+// mean_of_last_N / computeRollingAverage re-summing every tick and
+// the original decision code)
+//-----------------------------------------------
+namespace baseline1 {
+static const int    LONG_WINDOW           = 500;  // stays fixed
+static const double HIGH_SPREAD_THRESHOLD = 1.3;  // stays fixed
+static const int    POSITION_SIZE         = 100;  // stays fixed
+static const double FEES                  = 0.002; // fixed
+static const int    POSITION_LIMIT        = 100;  // fixed
+
+// We'll store the entire CSV in vectors:
+static std::vector<int>    g_ticks;
+static std::vector<double> g_bids;
+static std::vector<double> g_asks;
+static int                 g_nrows = 0;
+
+// Rolling averages by naive summation
+//------------------------------------
+static double mean_of_last_N(const std::vector<double>& arr, int N)
+{
+    double sum = 0.0;
+    int sz = (int)arr.size();
+    for(int i = sz - N; i < sz; i++){
+        sum += arr[i];
+    }
+    return sum / N;
+}
+
+//------------------------------------
+// Helper to run the entire backtest
+//------------------------------------
+double runBacktest(int short_window, 
+                   int waiting_period,
+                   double hs_exit_change_threshold,
+                   double ma_turn_threshold)
+{
+    // Strategy-state arrays (like "historical_data" in Python):
+    std::vector<int>    timestamp;
+    std::vector<double> bid_vec;
+    std::vector<double> ask_vec;
+    std::vector<double> mid_price;
+    std::vector<double> spread;
+    std::vector<double> short_avg;
+    std::vector<double> long_avg;
+    std::vector<int>    position_log;
+    std::vector<bool>   in_high_spread;
+    // trade_profit we keep for reference
+    std::vector<double> trade_profit;
+
+    // We'll keep them in function-scope (like global in Python).
+    bool   in_position                = false;
+    bool   position_is_long           = false;
+    double current_position_extreme   = 0.0;
+    bool   waiting_for_signal         = false;
+    int    high_spread_exit_index     = -1;
+    double last_high_spread_exit_savg = 0.0;
+
+    // There's only one product "UEC" => position & cash
+    int    pos  = 0;
+    double cash = 0.0;
+
+    auto record_trade_section = [&](int entry_i, int exit_i, 
+                                    double entry_price, double exit_price, 
+                                    int position_size){
+        double pr = 0.0;
+        if(position_size > 0){
+            pr = (exit_price - entry_price) * position_size;
+        } else if(position_size < 0){
+            pr = (entry_price - exit_price) * std::abs(position_size);
+        }
+        return pr;
+    };
+
+    auto update_history = [&](int t, double b, double a,
+                              double savg, double lavg,
+                              int p, bool hs, double tp)
+    {
+        timestamp.push_back(t);
+        bid_vec.push_back(b);
+        ask_vec.push_back(a);
+        double m = 0.5*(b+a);
+        mid_price.push_back(m);
+        double spr = a-b;
+        spread.push_back(spr);
+        short_avg.push_back(savg);
+        long_avg.push_back(lavg);
+        position_log.push_back(p);
+        in_high_spread.push_back(hs);
+        trade_profit.push_back(tp);
+    };
+
+    // Main loop: replicate the old approach
+    for(int i = 0; i < g_nrows; i++){
+        double b = g_bids[i];
+        double a = g_asks[i];
+        double m = 0.5*(b+a);
+        double spr = a - b;
+        bool hs = (spr >= HIGH_SPREAD_THRESHOLD);
+
+        double s_avg = NAN;
+        if((int)mid_price.size() >= short_window){
+            s_avg = mean_of_last_N(mid_price, short_window);
+        }
+        double l_avg = NAN;
+        if((int)mid_price.size() >= LONG_WINDOW){
+            l_avg = mean_of_last_N(mid_price, LONG_WINDOW);
+        }
+
+        int order_quantity = 0;
+        double trade_p = 0.0;
+
+        // (0) If in a position => check short_avg turn
+        if(!std::isnan(s_avg) && in_position){
+            if(position_is_long){
+                if(s_avg > current_position_extreme){
+                    current_position_extreme = s_avg;
+                } else {
+                    if((current_position_extreme - s_avg) >= ma_turn_threshold){
+                        // exit early
+                        int exit_index = (int)timestamp.size();
+                        int entry_index = -1;
+                        for(int k = (int)position_log.size()-1; k >= 0; k--){
+                            if(position_log[k] == 0){
+                                entry_index = k+1;
+                                break;
+                            }
+                        }
+                        if(entry_index >= 0 && entry_index < exit_index){
+                            double ep = mid_price[entry_index];
+                            double xp = m;
+                            trade_p = record_trade_section(entry_index, exit_index, ep, xp, pos);
+                        }
+                        order_quantity = -pos;
+                        in_position = false;
+                        position_is_long = false;
+                        current_position_extreme = 0.0;
+                    }
+                }
+            } else {
+                // short
+                if(s_avg < current_position_extreme){
+                    current_position_extreme = s_avg;
+                } else {
+                    if((s_avg - current_position_extreme) >= ma_turn_threshold){
+                        int exit_index = (int)timestamp.size();
+                        int entry_index = -1;
+                        for(int k = (int)position_log.size()-1; k >= 0; k--){
+                            if(position_log[k] == 0){
+                                entry_index = k+1;
+                                break;
+                            }
+                        }
+                        if(entry_index >= 0 && entry_index < exit_index){
+                            double ep = mid_price[entry_index];
+                            double xp = m;
+                            trade_p = record_trade_section(entry_index, exit_index, ep, xp, pos);
+                        }
+                        order_quantity = -pos;
+                        in_position = false;
+                        position_is_long = false;
+                        current_position_extreme = 0.0;
+                    }
+                }
+            }
+        }
+
+        // CASE 1: just exited high spread
+        if(!timestamp.empty() 
+           && in_high_spread.back()
+           && !hs)
+        {
+            high_spread_exit_index = (int)timestamp.size() - 1;
+            if(!std::isnan(s_avg)){
+                last_high_spread_exit_savg = s_avg;
+            } else {
+                last_high_spread_exit_savg = m;
+            }
+            waiting_for_signal = true;
+        }
+        // CASE 2: waited WAITING_PERIOD => new entry if not in HS
+        else if(waiting_for_signal
+                && ((int)timestamp.size() - high_spread_exit_index) >= waiting_period
+                && pos == 0
+                && !hs)
+        {
+            if(!std::isnan(s_avg)){
+                double diff = std::fabs(s_avg - last_high_spread_exit_savg);
+                if(diff >= hs_exit_change_threshold){
+                    // normal logic
+                    if(m > s_avg){
+                        order_quantity = POSITION_SIZE;
+                        in_position = true;
+                        position_is_long = true;
+                        current_position_extreme = s_avg;
+                    } else if(m < s_avg){
+                        order_quantity = -POSITION_SIZE;
+                        in_position = true;
+                        position_is_long = false;
+                        current_position_extreme = s_avg;
+                    }
+                    waiting_for_signal = false;
+                }
+            }
+        }
+        // CASE 3: in HS & have a position => close now
+        else if(hs && pos != 0){
+            int exit_index = (int)timestamp.size();
+            int entry_index = -1;
+            for(int k = (int)position_log.size()-1; k >= 0; k--){
+                if(position_log[k] == 0){
+                    entry_index = k+1;
+                    break;
+                }
+            }
+            if(entry_index >= 0 && entry_index < exit_index){
+                double ep = mid_price[entry_index];
+                double xp = m;
+                trade_p = record_trade_section(entry_index, exit_index, ep, xp, pos);
+            }
+            order_quantity = -pos;
+            in_position = false;
+            position_is_long = false;
+            current_position_extreme = 0.0;
+        }
+
+        // Update position & logs
+        int new_pos = pos + order_quantity;
+        // But apply the position limit & fees logic EXACTLY like the old code
+        // => we do it *outside* this logic or we match the old backtester?
+        // The old code forcibly set quant=0 if it would exceed limit. Then updated cash.
+
+        // We'll do it step-by-step as the old code:
+        // The final backtester code did something like:
+        //   if(quant > 0 && pos+quant > position_limit) => quant=0
+        //   if(quant < 0 && pos+quant < -position_limit)=> quant=0
+        //   if(quant>0) => cash -= ask*quant*(1+fees)
+        //   if(quant<0) => cash += bid*(-quant)*(1-fees)
+        // We'll replicate that carefully.
+
+        int actual_order = order_quantity;
+        // clamp buy
+        if(actual_order > 0 && (pos + actual_order > POSITION_LIMIT)){
+            actual_order = 0;
+        }
+        // clamp sell
+        if(actual_order < 0 && (pos + actual_order < -POSITION_LIMIT)){
+            actual_order = 0;
+        }
+        if(actual_order > 0){
+            cash -= a * actual_order * (1.0 + FEES);
+        } else if(actual_order < 0){
+            cash += b * (-actual_order) * (1.0 - FEES);
+        }
+        new_pos = pos + actual_order; // final position
+
+        // Now record to history
+        double use_savg = std::isnan(s_avg) ? m : s_avg;
+        double use_lavg = std::isnan(l_avg) ? m : l_avg;
+        update_history(g_ticks[i], b, a, use_savg, use_lavg, new_pos, hs, trade_p);
+
+        pos = new_pos;
+    }
+
+    // After loop, flatten any remaining position at final tick
+    if(pos != 0 && g_nrows>0){
+        double final_bid = g_bids[g_nrows - 1];
+        double final_ask = g_asks[g_nrows - 1];
+        if(pos > 0){
+            cash += final_bid * pos * (1.0 - FEES);
+        } else {
+            cash -= final_ask * (-pos) * (1.0 + FEES);
+        }
+    }
+
+    return cash;
+}
+}
+
+namespace baseline2 {
+// ---------------------------------------------------------
+// Constants used by the strategy
+// ---------------------------------------------------------
+static const int    LONG_WINDOW           = 500;
+static const double HIGH_SPREAD_THRESHOLD = 1.3;
+static const int    POSITION_SIZE         = 100;
+static const double FEES                  = 0.002;
+static const int    POSITION_LIMIT        = 100;
+
+// Helper: calculates the mean of the last N elements in an array
+static double mean_of_last_N(const std::vector<double>& arr, int N)
+{
+    double sum = 0.0;
+    int sz = (int)arr.size();
+    for (int i = sz - N; i < sz; i++) {
+        sum += arr[i];
+    }
+    return sum / N;
+}
+
+// ---------------------------------------------------------
+// runBacktest(): Implementation of the trading strategy
+// ---------------------------------------------------------
+double runBacktest(
+    int    short_window, 
+    int    waiting_period,
+    double hs_exit_change_threshold,
+    double ma_turn_threshold,
+    const std::vector<int>    &ticks,
+    const std::vector<double> &bids,
+    const std::vector<double> &asks
+)
+{
+    int nrows = (int)ticks.size();
+    if(nrows == 0) {
+        return 0.0;
+    }
+
+    // "Historical" arrays for logging strategy state
+    std::vector<int>    timestamp;
+    std::vector<double> bid_vec;
+    std::vector<double> ask_vec;
+    std::vector<double> mid_price;
+    std::vector<double> spread;
+    std::vector<double> short_avg;
+    std::vector<double> long_avg;
+    std::vector<int>    position_log;
+    std::vector<bool>   in_high_spread;
+    std::vector<double> trade_profit;
+
+    // Strategy states
+    bool   in_position                = false;
+    bool   position_is_long           = false;
+    double current_position_extreme   = 0.0;
+    bool   waiting_for_signal         = false;
+    int    high_spread_exit_index     = -1;
+    double last_high_spread_exit_savg = 0.0;
+
+    // Track position and cash
+    int    pos  = 0;
+    double cash = 0.0;
+
+    // Helper to record trade profit
+    auto record_trade_section = [&](int entry_i, int exit_i,
+                                  double entry_price, double exit_price,
+                                  int position_size)
+    {
+        double profit = 0.0;
+        if(position_size > 0) {
+            profit = (exit_price - entry_price) * position_size;
+        }
+        else if(position_size < 0) {
+            profit = (entry_price - exit_price) * std::abs(position_size);
+        }
+        return profit;
+    };
+
+    // Helper to update historical data
+    auto update_history = [&](int t, double b, double a,
+                            double savg, double lavg,
+                            int newpos, bool hs, double trp)
+    {
+        timestamp.push_back(t);
+        bid_vec.push_back(b);
+        ask_vec.push_back(a);
+        double m = 0.5 * (b + a);
+        mid_price.push_back(m);
+        spread.push_back(a - b);
+        short_avg.push_back(savg);
+        long_avg.push_back(lavg);
+        position_log.push_back(newpos);
+        in_high_spread.push_back(hs);
+        trade_profit.push_back(trp);
+    };
+
+    // Main backtest loop
+    for (int i = 0; i < nrows; i++)
+    {
+        double b = bids[i];
+        double a = asks[i];
+        double m = 0.5 * (b + a);
+        double spr = a - b;
+        bool hs = (spr >= HIGH_SPREAD_THRESHOLD);
+
+        // Calculate short/long rolling averages
+        double s_avg = std::numeric_limits<double>::quiet_NaN();
+        if((int)mid_price.size() >= short_window) {
+            s_avg = mean_of_last_N(mid_price, short_window);
+        }
+        double l_avg = std::numeric_limits<double>::quiet_NaN();
+        if((int)mid_price.size() >= LONG_WINDOW) {
+            l_avg = mean_of_last_N(mid_price, LONG_WINDOW);
+        }
+
+        int order_quantity = 0;
+        double trade_p = 0.0;
+
+        // 0) If in position => check if short_avg turned from extreme
+        if(!std::isnan(s_avg) && in_position) {
+            if(position_is_long) {
+                if(s_avg > current_position_extreme) {
+                    current_position_extreme = s_avg;
+                } else {
+                    if((current_position_extreme - s_avg) >= ma_turn_threshold) {
+                        // exit
+                        int exit_index = (int)timestamp.size();
+                        int entry_index = -1;
+                        for(int k=(int)position_log.size()-1; k>=0; k--) {
+                            if(position_log[k] == 0) {
+                                entry_index = k+1;
+                                break;
+                            }
+                        }
+                        if(entry_index >= 0 && entry_index < exit_index) {
+                            double ep = mid_price[entry_index];
+                            double xp = m;
+                            trade_p = record_trade_section(entry_index, exit_index, ep, xp, pos);
+                        }
+                        order_quantity = -pos; // close
+                        in_position = false;
+                        position_is_long = false;
+                        current_position_extreme = 0.0;
+                    }
+                }
+            }
+            else { // short
+                if(s_avg < current_position_extreme) {
+                    current_position_extreme = s_avg;
+                } else {
+                    if((s_avg - current_position_extreme) >= ma_turn_threshold) {
+                        int exit_index = (int)timestamp.size();
+                        int entry_index = -1;
+                        for(int k=(int)position_log.size()-1; k>=0; k--) {
+                            if(position_log[k] == 0) {
+                                entry_index = k+1;
+                                break;
+                            }
+                        }
+                        if(entry_index >= 0 && entry_index < exit_index) {
+                            double ep = mid_price[entry_index];
+                            double xp = m;
+                            trade_p = record_trade_section(entry_index, exit_index, ep, xp, pos);
+                        }
+                        order_quantity = -pos;
+                        in_position = false;
+                        position_is_long = false;
+                        current_position_extreme = 0.0;
+                    }
+                }
+            }
+        }
+
+        // 1) Just exited HS
+        if(!timestamp.empty() && in_high_spread.back() && !hs) {
+            high_spread_exit_index = (int)timestamp.size() - 1;
+            if(!std::isnan(s_avg)) {
+                last_high_spread_exit_savg = s_avg;
+            } else {
+                last_high_spread_exit_savg = m;
+            }
+            waiting_for_signal = true;
+        }
+        // 2) waited WAITING_PERIOD => check threshold for new entry
+        else if(waiting_for_signal 
+                && ((int)timestamp.size() - high_spread_exit_index) >= waiting_period
+                && pos == 0
+                && !hs)
+        {
+            if(!std::isnan(s_avg)) {
+                double diff = std::fabs(s_avg - last_high_spread_exit_savg);
+                if(diff >= hs_exit_change_threshold) {
+                    if(m > s_avg) {
+                        order_quantity = POSITION_SIZE;
+                        in_position = true;
+                        position_is_long = true;
+                        current_position_extreme = s_avg;
+                    } else if(m < s_avg) {
+                        order_quantity = -POSITION_SIZE;
+                        in_position = true;
+                        position_is_long = false;
+                        current_position_extreme = s_avg;
+                    }
+                    waiting_for_signal = false;
+                }
+            }
+        }
+        // 3) in HS & have a position => close now
+        else if(hs && pos != 0) {
+            int exit_index = (int)timestamp.size();
+            int entry_index = -1;
+            for(int k=(int)position_log.size()-1; k>=0; k--) {
+                if(position_log[k] == 0) {
+                    entry_index = k+1;
+                    break;
+                }
+            }
+            if(entry_index >= 0 && entry_index < exit_index) {
+                double ep = mid_price[entry_index];
+                double xp = m;
+                trade_p = record_trade_section(entry_index, exit_index, ep, xp, pos);
+            }
+            order_quantity = -pos;
+            in_position = false;
+            position_is_long = false;
+            current_position_extreme = 0.0;
+        }
+
+        // Apply position limits and update cash
+        int actual_order = order_quantity;
+        if(actual_order > 0 && (pos + actual_order) > POSITION_LIMIT) {
+            actual_order = 0;
+        }
+        if(actual_order < 0 && (pos + actual_order) < -POSITION_LIMIT) {
+            actual_order = 0;
+        }
+        if(actual_order > 0) {
+            cash -= a * actual_order * (1.0 + FEES);
+        }
+        else if(actual_order < 0) {
+            cash += b * (-actual_order) * (1.0 - FEES);
+        }
+        int new_pos = pos + actual_order;
+
+        // record to history
+        double use_savg = std::isnan(s_avg) ? m : s_avg;
+        double use_lavg = std::isnan(l_avg) ? m : l_avg;
+        update_history(ticks[i], b, a, use_savg, use_lavg, new_pos, hs, trade_p);
+
+        pos = new_pos;
+    }
+
+    // flatten final position
+    if(pos != 0) {
+        double final_bid = bids[nrows - 1];
+        double final_ask = asks[nrows - 1];
+        if(pos > 0) {
+            cash += final_bid * pos * (1.0 - FEES);
+        } else {
+            cash -= final_ask * (-pos) * (1.0 + FEES);
+        }
+    }
+
+    return cash;
+}
+}
+
+namespace baseline3 {
+// Fixed parameters
+const int LONG_WINDOW = 500;
+const double HIGH_SPREAD_THRESHOLD = 1.3;
+const int POSITION_SIZE = 100;
+const bool HOLD_DURING_HIGH_SPREAD = false;
+
+// Data structures
+struct PriceData {
+    double Bid;
+    double Ask;
+};
+
+struct BacktestResult {
+    double pnl;
+    double total_fees;
+};
+
+struct ParameterSet {
+    int short_window;
+    int waiting_period;
+    double hs_exit_change_threshold;
+    double ma_turn_threshold;
+    double pnl;
+
+    bool operator<(const ParameterSet& rhs) const {
+        return pnl < rhs.pnl;
+    }
+};
+
+// Optimized function to compute rolling average
+double computeRollingAverage(const std::vector<double>& midPrices, int endIndex, int windowSize) {
+    int startIndex = endIndex - windowSize + 1;
+    if(startIndex < 0) return std::numeric_limits<double>::quiet_NaN();
+    
+    double sum = 0.0;
+    for(int i = startIndex; i <= endIndex; i++) {
+        sum += midPrices[i];
+    }
+    return sum / windowSize;
+}
+
+
+BacktestResult runBacktest(const std::vector<PriceData>& priceData, const ParameterSet& params, bool verbose = false) {
+    // Initialize strategy state
+    bool in_position = false;
+    bool position_is_long = false;
+    bool waiting_for_signal = false;
+    bool holding_position_in_high_spread = false;
+    int high_spread_exit_index = -1;
+    int position_entry_index_in_hs = -1;
+    double last_high_spread_exit_short_avg = 0.0;
+    double prev_short_avg_in_hs = 0.0;
+    double current_position_extreme = 0.0;
+    
+    int currentPosition = 0;
+    double cash = 0.0;
+    double totalFees = 0.0;
+    
+    // Pre-allocate vector for midPrices
+    std::vector<double> midPrices(priceData.size(), 0.0);
+    
+    // Track previous high spread state between iterations
+    bool prev_in_high_spread = false;
+    
+    if (verbose) {
+        std::cout << "Running backtest with parameters:" << std::endl;
+        std::cout << "  Short Window: " << params.short_window << std::endl;
+        std::cout << "  Waiting Period: " << params.waiting_period << std::endl;
+        std::cout << "  HS Exit Threshold: " << params.hs_exit_change_threshold << std::endl;
+        std::cout << "  MA Turn Threshold: " << params.ma_turn_threshold << std::endl;
+    }
+    
+    const double fees_rate = 0.002; // 0.2%
+    const int position_limit = 100;
+    
+    // Run through all price data
+    for(size_t i = 0; i < priceData.size(); i++) {
+        double bid = priceData[i].Bid;
+        double ask = priceData[i].Ask;
+        double mid_price = 0.5 * (bid + ask);
+        double spread = ask - bid;
+        
+        // Store the current mid price
+        midPrices[i] = mid_price;
+        
+        // Compute rolling average with the parameter set
+        double short_avg = computeRollingAverage(midPrices, i, params.short_window);
+        
+        // Skip if not enough data points
+        if(std::isnan(short_avg)) continue;
+        
+        bool in_high_spread = (spread >= HIGH_SPREAD_THRESHOLD);
+        int order_quantity = 0;
+        
+        // 0) If in a position => check if short_avg turned from local extreme
+        if(in_position) {
+            if(position_is_long) {
+                if(short_avg > current_position_extreme) {
+                    current_position_extreme = short_avg;
+                } else {
+                    if((current_position_extreme - short_avg) >= params.ma_turn_threshold) {
+                        // early exit => close
+                        order_quantity = -currentPosition;
+                        
+                        // Reset state
+                        in_position = false;
+                        position_is_long = false;
+                        current_position_extreme = 0.0;
+                    }
+                }
+            } else {
+                // short
+                if(short_avg < current_position_extreme) {
+                    current_position_extreme = short_avg;
+                } else {
+                    if((short_avg - current_position_extreme) >= params.ma_turn_threshold) {
+                        order_quantity = -currentPosition;
+                        
+                        // Reset state
+                        in_position = false;
+                        position_is_long = false;
+                        current_position_extreme = 0.0;
+                    }
+                }
+            }
+        }
+
+        // 1) Just exited a high spread
+        if(prev_in_high_spread && !in_high_spread) {
+            high_spread_exit_index = i;
+            if(!std::isnan(short_avg)) {
+                last_high_spread_exit_short_avg = short_avg;
+            } else {
+                last_high_spread_exit_short_avg = mid_price;
+            }
+            waiting_for_signal = true;
+        }
+        prev_in_high_spread = in_high_spread;
+
+        // 2) waited WAITING_PERIOD => check threshold
+        if(waiting_for_signal) {
+            int diff = i - high_spread_exit_index;
+            if(diff >= params.waiting_period && currentPosition == 0 && !in_high_spread) {
+                if(!std::isnan(short_avg) && !std::isnan(last_high_spread_exit_short_avg)) {
+                    double delta = std::fabs(short_avg - last_high_spread_exit_short_avg);
+                    if(delta >= params.hs_exit_change_threshold) {
+                        // normal logic
+                        if(mid_price > short_avg) {
+                            order_quantity = POSITION_SIZE; // buy
+                            in_position = true;
+                            position_is_long = true;
+                            current_position_extreme = short_avg;
+                        } else if(mid_price < short_avg) {
+                            order_quantity = -POSITION_SIZE; // sell
+                            in_position = true;
+                            position_is_long = false;
+                            current_position_extreme = short_avg;
+                        }
+                        waiting_for_signal = false;
+                    }
+                }
+            }
+        }
+
+        // 3) If in high spread + have position => immediate close
+        if(in_high_spread && currentPosition != 0) {
+            order_quantity = -currentPosition;
+            in_position = false;
+            position_is_long = false;
+            current_position_extreme = 0.0;
+        }
+        
+        // Process the order
+        if(order_quantity != 0) {
+            // Check position limit
+            if(order_quantity > 0) {
+                // Buying
+                if(currentPosition + order_quantity > position_limit) {
+                    if (verbose) {
+                        std::cout << "[LOG] Attempted buy beyond limit for UEC, ignoring." << std::endl;
+                    }
+                    order_quantity = 0;
+                }
+                
+                if (order_quantity > 0) {
+                    double cost = ask * order_quantity * (1.0 + fees_rate);
+                    cash -= cost;
+                    double fees_incurred = ask * order_quantity * fees_rate;
+                    totalFees += fees_incurred;
+                    
+                    if (verbose) {
+                        std::cout << "[LOG] Buying " << order_quantity << " of UEC at " 
+                                << std::fixed << std::setprecision(3) << ask 
+                                << "; Fees = " << std::fixed << std::setprecision(3) << fees_incurred << std::endl;
+                    }
+                }
+            } else {
+                // Selling
+                if(currentPosition + order_quantity < -position_limit) {
+                    if (verbose) {
+                        std::cout << "[LOG] Attempted sell beyond limit for UEC, ignoring." << std::endl;
+                    }
+                    order_quantity = 0;
+                }
+                
+                if (order_quantity < 0) {
+                    double revenue = bid * (-order_quantity) * (1.0 - fees_rate);
+                    cash += revenue;
+                    double fees_incurred = bid * (-order_quantity) * fees_rate;
+                    totalFees += fees_incurred;
+                    
+                    if (verbose) {
+                        std::cout << "[LOG] Selling " << -order_quantity << " of UEC at " 
+                                << std::fixed << std::setprecision(3) << bid 
+                                << "; Fees = " << std::fixed << std::setprecision(3) << fees_incurred << std::endl;
+                    }
+                }
+            }
+            
+            currentPosition += order_quantity;
+        }
+    }
+    
+    // Final close
+    if (verbose) {
+        std::cout << "\n=== Closing Any Open Positions ===" << std::endl;
+        std::cout << "[INFO] UEC unclosed before final close: PnL = " 
+                << std::fixed << std::setprecision(2) << cash 
+                << ", Position = " << currentPosition << std::endl;
+    }
+    
+    if(currentPosition > 0) {
+        double finalBid = priceData.back().Bid;
+        double final_sell_amount = finalBid * currentPosition * (1.0 - fees_rate);
+        cash += final_sell_amount;
+        double fees_incurred = finalBid * currentPosition * fees_rate;
+        totalFees += fees_incurred;
+        
+        if (verbose) {
+            std::cout << "[LOG] Final close SELL " << currentPosition 
+                    << " UEC at " << std::fixed << std::setprecision(3) << finalBid 
+                    << "; Fees = " << std::fixed << std::setprecision(3) << fees_incurred << std::endl;
+        }
+        currentPosition = 0;
+    }
+    else if(currentPosition < 0) {
+        double finalAsk = priceData.back().Ask;
+        double final_buy_amount = finalAsk * (-currentPosition) * (1.0 + fees_rate);
+        cash -= final_buy_amount;
+        double fees_incurred = finalAsk * (-currentPosition) * fees_rate;
+        totalFees += fees_incurred;
+        
+        if (verbose) {
+            std::cout << "[LOG] Final close BUY " << -currentPosition 
+                    << " UEC at " << std::fixed << std::setprecision(3) << finalAsk 
+                    << "; Fees = " << std::fixed << std::setprecision(3) << fees_incurred << std::endl;
+        }
+        currentPosition = 0;
+    }
+    
+    if (verbose) {
+        std::cout << "[INFO] UEC closed: PnL = " << std::fixed << std::setprecision(2) << cash << std::endl;
+    }
+    
+    BacktestResult result;
+    result.pnl = cash;
+    result.total_fees = totalFees;
+    
+    if (verbose) {
+        std::cout << "Final PnL: " << std::fixed << std::setprecision(2) << cash << std::endl;
+        std::cout << "Total Fees: " << std::fixed << std::setprecision(2) << totalFees << std::endl;
+    }
+    
+    return result;
+}
+}
+
+//-----------------------------------------------
+// Loads timestamp,bid,ask rows; false if none
+//-----------------------------------------------
+static bool loadCsv(const std::string &path, std::vector<int> &ticks,
+                    std::vector<double> &bids, std::vector<double> &asks)
+{
+    std::ifstream fin(path);
+    if (!fin.is_open()) {
+        return false;
+    }
+    std::string line;
+    std::getline(fin, line); // header
+    while (std::getline(fin, line)) {
+        if (line.empty()) continue;
+        std::stringstream ss(line);
+        std::string c1, c2, c3;
+        if (std::getline(ss, c1, ',') &&
+            std::getline(ss, c2, ',') &&
+            std::getline(ss, c3, ','))
+        {
+            ticks.push_back(std::stoi(c1));
+            bids.push_back(std::stod(c2));
+            asks.push_back(std::stod(c3));
+        }
+    }
+    return !ticks.empty();
+}
+
+//-----------------------------------------------
+// Main function
+//   rolling_window_check csv...
+// Runs each tree's current backtest over a spread of short windows
+// and compares the PnL with that tree's baseline. The kernels are
+// meant to be bit-identical, so any difference at all is a failure.
+//-----------------------------------------------
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " data.csv [more.csv ...]" << std::endl;
+        return 2;
+    }
+
+    // Short windows from 1 tick up past LONG_WINDOW, including the
+    // fixed-kernel range around 80
+    const int windows[] = {1, 2, 3, 7, 16, 50, 68, 80, 92, 127, 250, 500, 1000};
+    const int waits[] = {72, 88};
+    const double hsx[] = {0.18, 0.22};
+    const double mat[] = {0.81, 0.99};
+
+    int runs = 0;
+    int failures = 0;
+    for (int f = 1; f < argc; f++) {
+        std::vector<int> ticks;
+        std::vector<double> bids, asks;
+        if (!loadCsv(argv[f], ticks, bids, asks)) {
+            std::cerr << "Error: No data loaded from " << argv[f] << std::endl;
+            return 2;
+        }
+        PreparedDataset data(ticks, bids, asks);
+
+        baseline1::g_ticks = try1::g_ticks = ticks;
+        baseline1::g_bids  = try1::g_bids  = bids;
+        baseline1::g_asks  = try1::g_asks  = asks;
+        baseline1::g_nrows = try1::g_nrows = (int)ticks.size();
+
+        std::vector<baseline3::PriceData> prices3;
+        for (size_t i = 0; i < bids.size(); i++) {
+            prices3.push_back({bids[i], asks[i]});
+        }
+        std::vector<try3::PriceData> pricesNow3(prices3.size());
+        for (size_t i = 0; i < prices3.size(); i++) {
+            pricesNow3[i] = {prices3[i].Bid, prices3[i].Ask};
+        }
+
+        int mismatches = 0;
+        auto check = [&](const char *tree, const char *kernel, int sw, int wp, double h, double m,
+                         double reference, double pnl){
+            runs++;
+            if (pnl == reference) return;
+            mismatches++;
+            std::cerr << std::fixed << std::setprecision(6)
+                      << "MISMATCH " << argv[f] << " " << tree << " " << kernel
+                      << " sw=" << sw << " wp=" << wp << " hsx=" << h << " mat=" << m
+                      << ": baseline " << reference << ", now " << pnl << std::endl;
+        };
+
+        for (int sw : windows)
+            for (int wp : waits)
+                for (double h : hsx)
+                    for (double m : mat) {
+                        double ref2 = baseline2::runBacktest(sw, wp, h, m, ticks, bids, asks);
+                        BacktestTrace trace;
+                        check("try2", "streaming", sw, wp, h, m, ref2, runBacktest(sw, wp, h, m, ticks, bids, asks));
+                        check("try2", "traced", sw, wp, h, m, ref2, runBacktest(sw, wp, h, m, ticks, bids, asks, trace));
+                        check("try2", "prepared", sw, wp, h, m, ref2, runBacktest(sw, wp, h, m, data));
+
+                        check("try1", "runBacktest", sw, wp, h, m,
+                              baseline1::runBacktest(sw, wp, h, m), try1::runBacktest(sw, wp, h, m));
+
+                        // Both trees book the same closed trades
+                        std::vector<TradeRecord> trades2;
+                        std::vector<try1::TradeRecord> trades1;
+                        runBacktest(sw, wp, h, m, ticks, bids, asks, trades2);
+                        try1::runBacktest(sw, wp, h, m, &trades1);
+                        bool same = trades1.size() == trades2.size();
+                        for (size_t t = 0; same && t < trades1.size(); t++) {
+                            same = trades1[t].entry_index == trades2[t].entry_index
+                                && trades1[t].exit_index  == trades2[t].exit_index
+                                && trades1[t].side        == trades2[t].side
+                                && trades1[t].profit      == trades2[t].profit;
+                        }
+                        check("try1", "trades vs try2", sw, wp, h, m, (double)trades2.size(),
+                              same ? (double)trades2.size() : -1.0);
+
+                        baseline3::ParameterSet p3{sw, wp, h, m, 0.0};
+                        try3::ParameterSet now3{sw, wp, h, m, 0.0};
+                        check("try3", "runBacktest", sw, wp, h, m,
+                              baseline3::runBacktest(prices3, p3).pnl, try3::runBacktest(pricesNow3, now3).pnl);
+                    }
+        failures += mismatches;
+        std::cout << argv[f] << ": " << ticks.size() << " rows, " << mismatches << " mismatches" << std::endl;
+    }
+
+    std::cout << runs << " comparisons, " << failures << " mismatches" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,235 @@
+#ifndef STRATEGY_H
+#define STRATEGY_H
+
+// Internal to the backtester library: constants and per-run state shared
+// by the backtest kernels.
+
+#include "../include/Backtester.h"
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+
+// ---------------------------------------------------------
+// Constants used by the strategy
+// ---------------------------------------------------------
+static const int    LONG_WINDOW           = 500;
+static const double HIGH_SPREAD_THRESHOLD = 1.3;
+static const int    POSITION_SIZE         = 100;
+static const double FEES                  = 0.002;
+static const int    POSITION_LIMIT        = 100;
+
+// ---------------------------------------------------------
+// Tunable parameters of one backtest
+// ---------------------------------------------------------
+struct StrategyParams {
+    int    short_window;
+    int    waiting_period;
+    double hs_exit_change_threshold;
+    double ma_turn_threshold;
+    int    position_size = POSITION_SIZE;
+
+    // Structural switches (see StrategyVariant)
+    bool   hold_during_high_spread = false;
+    int    entry_sides             = 0;
+};
+
+// ---------------------------------------------------------
+// Strategy state carried from tick to tick
+// ---------------------------------------------------------
+struct StrategyState {
+    bool   in_position                = false;
+    bool   position_is_long           = false;
+    double current_position_extreme   = 0.0;
+    bool   waiting_for_signal         = false;
+    int    high_spread_exit_index     = -1;
+    double last_high_spread_exit_savg = 0.0;
+    bool   prev_hs                    = false;
+
+    // Open trade, set when the position leaves zero
+    int    entry_index                = -1;
+    double entry_mid                  = 0.0;
+    int    entry_side                 = 0;
+
+    // Holding through a high spread: short avg on the previous HS tick
+    bool   holding_in_hs              = false;
+    double prev_savg_in_hs            = 0.0;
+
+    // Track position and cash
+    int    pos                        = 0;
+    double cash                       = 0.0;
+};
+
+// Books the open trade closed at exit_i; O(1) from the entry state
+inline double closeTrade(const StrategyState &st, int exit_i, double exit_price,
+                         std::vector<TradeRecord> *trades)
+{
+    double profit = 0.0;
+    if(st.pos > 0) {
+        profit = (exit_price - st.entry_mid) * st.pos;
+    }
+    else if(st.pos < 0) {
+        profit = (st.entry_mid - exit_price) * std::abs(st.pos);
+    }
+    if(trades) {
+        trades->push_back({st.entry_index, exit_i, st.entry_side, profit});
+    }
+    return profit;
+}
+
+// ---------------------------------------------------------
+// strategyStep(): one tick of the UEC strategy
+//   Runs the exit / high-spread / entry decisions, applies the
+//   resulting order with position limits and fees, and returns
+//   the trade profit booked on this tick (0 if none). s_avg is
+//   the mean of the short_window mids before tick i, or NaN.
+// ---------------------------------------------------------
+inline double strategyStep(StrategyState &st, const StrategyParams &p, int i,
+                           double b, double a, double m, bool hs, double s_avg,
+                           std::vector<TradeRecord> *trades)
+{
+    int order_quantity = 0;
+    double trade_p = 0.0;
+
+    // 0) If in position => check if short_avg turned from extreme
+    if(!std::isnan(s_avg) && st.in_position) {
+        if(st.position_is_long) {
+            if(s_avg > st.current_position_extreme) {
+                st.current_position_extreme = s_avg;
+            } else {
+                if((st.current_position_extreme - s_avg) >= p.ma_turn_threshold) {
+                    // exit
+                    trade_p = closeTrade(st, i, m, trades);
+                    order_quantity = -st.pos; // close
+                    st.in_position = false;
+                    st.position_is_long = false;
+                    st.current_position_extreme = 0.0;
+                }
+            }
+        }
+        else { // short
+            if(s_avg < st.current_position_extreme) {
+                st.current_position_extreme = s_avg;
+            } else {
+                if((s_avg - st.current_position_extreme) >= p.ma_turn_threshold) {
+                    trade_p = closeTrade(st, i, m, trades);
+                    order_quantity = -st.pos;
+                    st.in_position = false;
+                    st.position_is_long = false;
+                    st.current_position_extreme = 0.0;
+                }
+            }
+        }
+    }
+
+    // 1) Just exited HS. A position held through the spread is still
+    //    open, so no entry is armed from this exit; otherwise (2) could
+    //    fire from its stale short avg once the MA turn closes the trade
+    if(i > 0 && st.prev_hs && !hs) {
+        st.high_spread_exit_index = i - 1;
+        if(!std::isnan(s_avg)) {
+            st.last_high_spread_exit_savg = s_avg;
+        } else {
+            st.last_high_spread_exit_savg = m;
+        }
+        st.waiting_for_signal = !st.in_position;
+    }
+    // 2) waited WAITING_PERIOD => check threshold for new entry
+    else if(st.waiting_for_signal
+            && (i - st.high_spread_exit_index) >= p.waiting_period
+            && st.pos == 0
+            && !hs)
+    {
+        if(!std::isnan(s_avg)) {
+            double diff = std::fabs(s_avg - st.last_high_spread_exit_savg);
+            if(diff >= p.hs_exit_change_threshold) {
+                if(m > s_avg && p.entry_sides >= 0) {
+                    order_quantity = p.position_size;
+                    st.in_position = true;
+                    st.position_is_long = true;
+                    st.current_position_extreme = s_avg;
+                } else if(m < s_avg && p.entry_sides <= 0) {
+                    order_quantity = -p.position_size;
+                    st.in_position = true;
+                    st.position_is_long = false;
+                    st.current_position_extreme = s_avg;
+                }
+                st.waiting_for_signal = false;
+            }
+        }
+    }
+    // 3) in HS & have a position => close now, or when holding through
+    //    the spread, once the short avg turns against the position
+    else if(hs && st.pos != 0) {
+        bool close_now = true;
+        if(p.hold_during_high_spread && st.in_position) {
+            if(!st.holding_in_hs) {
+                st.holding_in_hs = true;
+                st.prev_savg_in_hs = s_avg;
+                close_now = false;
+            } else if(!std::isnan(s_avg) && !std::isnan(st.prev_savg_in_hs)) {
+                close_now = st.position_is_long ? (s_avg < st.prev_savg_in_hs)
+                                                : (s_avg > st.prev_savg_in_hs);
+                st.prev_savg_in_hs = s_avg;
+            } else {
+                close_now = false;
+            }
+        }
+        if(close_now) {
+            // (0) may already have booked this exit on the same tick
+            if(st.in_position) {
+                trade_p = closeTrade(st, i, m, trades);
+            }
+            order_quantity = -st.pos;
+            st.in_position = false;
+            st.position_is_long = false;
+            st.current_position_extreme = 0.0;
+            st.holding_in_hs = false;
+        }
+    }
+    if(!hs) {
+        st.holding_in_hs = false;
+    }
+
+    // Apply position limits and update cash
+    int actual_order = order_quantity;
+    if(actual_order > 0 && (st.pos + actual_order) > POSITION_LIMIT) {
+        actual_order = 0;
+    }
+    if(actual_order < 0 && (st.pos + actual_order) < -POSITION_LIMIT) {
+        actual_order = 0;
+    }
+    if(actual_order > 0) {
+        st.cash -= a * actual_order * (1.0 + FEES);
+    }
+    else if(actual_order < 0) {
+        st.cash += b * (-actual_order) * (1.0 - FEES);
+    }
+    int new_pos = st.pos + actual_order;
+
+    // remember where the new trade started
+    if(st.pos == 0 && new_pos != 0) {
+        st.entry_index = i;
+        st.entry_mid   = m;
+        st.entry_side  = (new_pos > 0) ? 1 : -1;
+    }
+
+    st.prev_hs = hs;
+    st.pos = new_pos;
+    return trade_p;
+}
+
+// Closes any position left open after the last tick
+inline void flattenPosition(StrategyState &st, int last_i, double final_bid, double final_ask,
+                            std::vector<TradeRecord> *trades)
+{
+    if(st.pos != 0) {
+        closeTrade(st, last_i, 0.5 * (final_bid + final_ask), trades);
+        if(st.pos > 0) {
+            st.cash += final_bid * st.pos * (1.0 - FEES);
+        } else {
+            st.cash -= final_ask * (-st.pos) * (1.0 + FEES);
+        }
+    }
+}
+
+#endif // STRATEGY_H
@@ -7,13 +7,16 @@
 #include <cmath>
 #include <limits>
 #include <algorithm>
+#include <tuple>
 #include <iomanip> // For std::setprecision
 #include <thread>
 #include <mutex>
-#include <queue>
 #include <chrono>
 #include <atomic>
 
+#include "../try2/include/TopK.h"
+#include "../try2/include/WorkStealing.h"
+
 // Structure for parameters
 struct ParameterSet {
     int short_window;
@@ -400,42 +403,36 @@ std::vector<PriceData> loadCSV(const std::string& filename) {
 }
 
 // Global variables for thread coordination
-std::mutex resultMutex;
-std::priority_queue<ParameterSet> bestResults;
+using BestResults = WorkerTopK<ParameterSet, 10>;
+std::vector<BestResults> workerBest;   // one per worker thread
 std::atomic<int> completedTasks(0);
 std::atomic<int> runningTasks(0);
 int totalTasks = 0;
 
-// Thread worker function for grid search
-void workerThread(const std::vector<PriceData>& priceData, std::vector<ParameterSet> paramSets) {
-    for (auto& params : paramSets) {
-        if(params.short_window <= 0 || params.waiting_period <= 0) continue;
-        
-        runningTasks++;
-        BacktestResult result = runBacktest(priceData, params);
-        params.pnl = result.pnl;
-        
-        // Add to best results
-        {
-            std::lock_guard<std::mutex> lock(resultMutex);
-            bestResults.push(params);
-            // Keep only top 10 results
-            if (bestResults.size() > 10) {
-                // Create a new queue with just the top 10
-                std::priority_queue<ParameterSet> newQueue;
-                for (int i = 0; i < 10; i++) {
-                    if (bestResults.empty()) break;
-                    newQueue.push(bestResults.top());
-                    bestResults.pop();
-                }
-                bestResults = std::move(newQueue);
+// Thread worker function for grid search: runs the index ranges the
+// scheduler hands it. Results go to the worker's own best list, so
+// threads never lock each other out.
+void workerThread(const std::vector<PriceData>& priceData, const std::vector<ParameterSet>& paramSets,
+                  WorkStealingScheduler& sched, unsigned int worker) {
+    BestResults& best = workerBest[worker];
+    sched.work(worker, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            ParameterSet params = paramSets[i];
+            if(params.short_window <= 0 || params.waiting_period <= 0) {
+                completedTasks++;
+                continue;
             }
+            
+            runningTasks++;
+            BacktestResult result = runBacktest(priceData, params);
+            params.pnl = result.pnl;
+            best.offer(params);
+            
+            // Update progress
+            completedTasks++;
+            runningTasks--;
         }
-        
-        // Update progress
-        completedTasks++;
-        runningTasks--;
-    }
+    });
 }
 
 // Function to print progress bar
@@ -453,6 +450,10 @@ void printProgressBar(int width, float progress) {
 
 // Function to display top results
 void displayTopResults(int n = 3) {
+    // Merge the workers' latest snapshots (highest PnL first)
+    std::vector<ParameterSet> topResults = mergeSnapshots(workerBest, n);
+    if (topResults.empty()) return;
+    
     std::cout << "\nTop " << n << " parameter sets:" << std::endl;
     std::cout << std::setw(15) << "Short Window" 
               << std::setw(15) << "Wait Period" 
@@ -460,19 +461,6 @@ void displayTopResults(int n = 3) {
               << std::setw(15) << "MA Turn Thres" 
               << std::setw(15) << "PnL" << std::endl;
     
-    // Copy queue to array to display in order
-    std::vector<ParameterSet> topResults;
-    std::priority_queue<ParameterSet> tempQueue = bestResults;
-    
-    while (!tempQueue.empty() && topResults.size() < n) {
-        topResults.push_back(tempQueue.top());
-        tempQueue.pop();
-    }
-    
-    // Sort in descending order (highest PnL first)
-    std::sort(topResults.begin(), topResults.end(), 
-              [](const ParameterSet& a, const ParameterSet& b) { return a.pnl > b.pnl; });
-    
     for (const auto& result : topResults) {
         std::cout << std::setw(15) << result.short_window
                   << std::setw(15) << result.waiting_period
@@ -483,6 +471,23 @@ void displayTopResults(int n = 3) {
     std::cout << std::endl;
 }
 
+// Canonicalizes the grid: sorts by parameters and drops repeated sets
+// (static_cast<int> maps several multipliers to the same window), so each
+// distinct set is backtested once. Returns how many were dropped.
+size_t dedupParamSets(std::vector<ParameterSet>& paramSets) {
+    auto key = [](const ParameterSet& p) {
+        return std::make_tuple(p.short_window, p.waiting_period,
+                               p.hs_exit_change_threshold, p.ma_turn_threshold);
+    };
+    std::sort(paramSets.begin(), paramSets.end(),
+              [&](const ParameterSet& a, const ParameterSet& b) { return key(a) < key(b); });
+    auto last = std::unique(paramSets.begin(), paramSets.end(),
+                            [&](const ParameterSet& a, const ParameterSet& b) { return key(a) == key(b); });
+    size_t dropped = std::distance(last, paramSets.end());
+    paramSets.erase(last, paramSets.end());
+    return dropped;
+}
+
 // Main function
 int main() {
     // 1. Load CSV data
@@ -548,10 +553,14 @@ int main() {
         }
     }
     
+    size_t gridSize = allParamSets.size();
+    size_t redundant = dedupParamSets(allParamSets);
     totalTasks = allParamSets.size();
     
     std::cout << "=== Starting Parameter Grid Search ===" << std::endl;
-    std::cout << "Number of parameter combinations: " << totalTasks << std::endl;
+    std::cout << "Number of parameter combinations: " << totalTasks
+              << " (" << gridSize << " grid points, " << redundant
+              << " redundant backtests skipped)" << std::endl;
     std::cout << "Parameter ranges:" << std::endl;
     std::cout << "  Short Window: " << short_window_values.front() << " to " << short_window_values.back() << std::endl;
     std::cout << "  Waiting Period: " << waiting_period_values.front() << " to " << waiting_period_values.back() << std::endl;
@@ -564,19 +573,16 @@ int main() {
     
     std::cout << "Using " << numThreads << " threads" << std::endl;
     
-    // Split work among threads
+    // Workers share the grid read-only and take index ranges from the scheduler
     std::vector<std::thread> threads;
-    std::vector<std::vector<ParameterSet>> threadWorkloads(numThreads);
-    
-    for (size_t i = 0; i < allParamSets.size(); i++) {
-        threadWorkloads[i % numThreads].push_back(allParamSets[i]);
-    }
+    workerBest = std::vector<BestResults>(numThreads);
     
     // Start the threads
     auto start_time = std::chrono::high_resolution_clock::now();
+    WorkStealingScheduler sched(allParamSets.size(), numThreads);
     
     for (unsigned int i = 0; i < numThreads; i++) {
-        threads.emplace_back(workerThread, std::ref(priceData), threadWorkloads[i]);
+        threads.emplace_back(workerThread, std::cref(priceData), std::cref(allParamSets), std::ref(sched), i);
     }
     
     // Monitor progress and display top results
@@ -593,10 +599,7 @@ int main() {
         if (currentPercent != lastPercent || 
             (currentPercent < 10 && static_cast<int>(progress * 1000) % 10 == 0)) {
             lastPercent = currentPercent;
-            std::lock_guard<std::mutex> lock(resultMutex);
-            if (!bestResults.empty()) {
-                displayTopResults(3);
-            }
+            displayTopResults(3);
         }
         
         std::this_thread::sleep_for(std::chrono::milliseconds(500));
@@ -615,6 +618,7 @@ int main() {
     
     std::cout << "\n=== Grid Search Complete ===" << std::endl;
     std::cout << "Total time: " << duration << " seconds" << std::endl;
+    sched.report(std::cout);
     
     // Display final top 10 results
     std::cout << "\nTop 10 parameter sets:" << std::endl;
@@ -624,16 +628,12 @@ int main() {
               << std::setw(15) << "MA Turn Thres" 
               << std::setw(15) << "PnL" << std::endl;
     
-    // Copy queue to array to display in order
-    std::vector<ParameterSet> topResults;
-    while (!bestResults.empty()) {
-        topResults.push_back(bestResults.top());
-        bestResults.pop();
+    // Merge the workers' best lists once, now that they have finished
+    TopK<ParameterSet, 10> best;
+    for (const auto& w : workerBest) {
+        best.merge(w.result());
     }
-    
-    // Sort in descending order (highest PnL first)
-    std::sort(topResults.begin(), topResults.end(), 
-              [](const ParameterSet& a, const ParameterSet& b) { return a.pnl > b.pnl; });
+    std::vector<ParameterSet> topResults = best.sorted();
     
     for (const auto& result : topResults) {
         std::cout << std::setw(15) << result.short_window
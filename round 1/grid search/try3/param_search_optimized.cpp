@@ -6,12 +6,21 @@
 #include <cmath>
 #include <limits>
 #include <algorithm>
+#include <tuple>
 #include <iomanip>
 #include <thread>
 #include <mutex>
 #include <queue>
+#include <functional>
 #include <chrono>
 #include <atomic>
+#include <cstdint>
+#include <cstdio>
+
+#include "../try2/include/RollingWindow.h"
+#include "../try2/include/GridRefiner.h"
+#include "../try2/include/TopK.h"
+#include "../try2/include/WorkStealing.h"
 
 // Constants from PanicTrader.py with ranges for searching
 const int BASE_SHORT_WINDOW = 80;
@@ -49,27 +58,16 @@ struct ParameterSet {
 };
 
 // Global variables for thread coordination
-std::mutex resultMutex;
-std::priority_queue<ParameterSet> bestResults;
+using BestResults = WorkerTopK<ParameterSet, 10>;
+std::vector<BestResults> workerBest;       // one per worker thread
+TopK<ParameterSet, 10> restoredBest;       // results restored from a checkpoint
 std::atomic<int> completedTasks(0);
 std::atomic<int> runningTasks(0);
 int totalTasks = 0;
 
-// Optimized function to compute rolling average
-double computeRollingAverage(const std::vector<double>& midPrices, int endIndex, int windowSize) {
-    int startIndex = endIndex - windowSize + 1;
-    if(startIndex < 0) return std::numeric_limits<double>::quiet_NaN();
-    
-    double sum = 0.0;
-    for(int i = startIndex; i <= endIndex; i++) {
-        sum += midPrices[i];
-    }
-    return sum / windowSize;
-}
-
 // Core strategy logic, optimized for performance
 int getOrders(const PriceData& data, int timeIndex, int& currentPosition, double& cash, double& totalFees,
-              std::vector<double>& midPrices, const ParameterSet& params,
+              RollingWindow& shortWindow, const ParameterSet& params,
               bool& in_position, bool& position_is_long, bool& waiting_for_signal,
               int& high_spread_exit_index, double& last_high_spread_exit_short_avg,
               double& current_position_extreme, bool& prev_in_high_spread) {
@@ -78,11 +76,9 @@ int getOrders(const PriceData& data, int timeIndex, int& currentPosition, double
     double mid_price = 0.5 * (bid + ask);
     double spread = ask - bid;
     
-    // Store the current mid price
-    midPrices[timeIndex] = mid_price;
-    
-    // Compute rolling averages with the parameter set
-    double short_avg = computeRollingAverage(midPrices, timeIndex, params.short_window);
+    // Push the current mid price and read the rolling average (O(1))
+    shortWindow.push(mid_price);
+    double short_avg = shortWindow.mean();
     
     // Skip if not enough data points
     if(std::isnan(short_avg)) return 0;
@@ -187,8 +183,8 @@ BacktestResult runBacktest(const std::vector<PriceData>& priceData, const Parame
     double cash = 0.0;
     double totalFees = 0.0;
     
-    // Pre-allocate vector for midPrices
-    std::vector<double> midPrices(priceData.size(), 0.0);
+    // Streaming short-window average (includes the current tick)
+    RollingWindow shortWindow(params.short_window);
     
     // Track previous high spread state between iterations
     bool prev_in_high_spread = false;
@@ -211,11 +207,9 @@ BacktestResult runBacktest(const std::vector<PriceData>& priceData, const Parame
         double mid_price = 0.5 * (bid + ask);
         double spread = ask - bid;
         
-        // Store the current mid price
-        midPrices[i] = mid_price;
-        
-        // Compute rolling average with the parameter set
-        double short_avg = computeRollingAverage(midPrices, i, params.short_window);
+        // Push the current mid price and read the rolling average (O(1))
+        shortWindow.push(mid_price);
+        double short_avg = shortWindow.mean();
         
         // Skip if not enough data points
         if(std::isnan(short_avg)) continue;
@@ -405,6 +399,68 @@ BacktestResult runBacktest(const std::vector<PriceData>& priceData, const Parame
     return result;
 }
 
+// Strategy state at a tick boundary, so a backtest can stop there and resume
+// later. The short window is kept as (ticks pushed, running sum): its
+// samples are just the preceding mids, so RollingWindow::restore() rebuilds
+// it exactly and a checkpoint stays a few dozen bytes.
+struct BacktestCheckpoint {
+    size_t nextTick = 0;
+    double windowSum = 0.0;
+    bool in_position = false;
+    bool position_is_long = false;
+    bool waiting_for_signal = false;
+    bool prev_in_high_spread = false;
+    int high_spread_exit_index = -1;
+    double last_high_spread_exit_short_avg = 0.0;
+    double current_position_extreme = 0.0;
+    int currentPosition = 0;
+    double cash = 0.0;
+    double totalFees = 0.0;
+};
+
+// Runs ticks [cp.nextTick, endTick) and leaves cp at endTick. Same decisions
+// and order handling as runBacktest(), so resuming in any number of steps
+// ends in the same state as one uninterrupted run.
+void resumeBacktest(const std::vector<PriceData>& priceData, const std::vector<double>& mids,
+                    const ParameterSet& params, BacktestCheckpoint& cp, size_t endTick) {
+    const double fees_rate = 0.002; // 0.2%
+    const int position_limit = 100;
+
+    static thread_local RollingWindow shortWindow;
+    shortWindow.restore(params.short_window, mids.data(), (long)cp.nextTick, cp.windowSum);
+
+    for(size_t i = cp.nextTick; i < endTick; i++) {
+        int order_quantity = getOrders(priceData[i], (int)i, cp.currentPosition, cp.cash, cp.totalFees,
+                                       shortWindow, params, cp.in_position, cp.position_is_long,
+                                       cp.waiting_for_signal, cp.high_spread_exit_index,
+                                       cp.last_high_spread_exit_short_avg, cp.current_position_extreme,
+                                       cp.prev_in_high_spread);
+        if(order_quantity > 0 && cp.currentPosition + order_quantity > position_limit) order_quantity = 0;
+        if(order_quantity < 0 && cp.currentPosition + order_quantity < -position_limit) order_quantity = 0;
+        if(order_quantity > 0) {
+            cp.cash -= priceData[i].Ask * order_quantity * (1.0 + fees_rate);
+            cp.totalFees += priceData[i].Ask * order_quantity * fees_rate;
+        } else if(order_quantity < 0) {
+            cp.cash += priceData[i].Bid * (-order_quantity) * (1.0 - fees_rate);
+            cp.totalFees += priceData[i].Bid * (-order_quantity) * fees_rate;
+        }
+        cp.currentPosition += order_quantity;
+    }
+    cp.nextTick = endTick;
+    cp.windowSum = shortWindow.sum();
+}
+
+// PnL at the checkpoint with any open position closed at its last tick, the
+// way runBacktest() closes at the end of the data
+double checkpointPnl(const std::vector<PriceData>& priceData, const BacktestCheckpoint& cp) {
+    const double fees_rate = 0.002;
+    if(cp.nextTick == 0) return cp.cash;
+    const PriceData& last = priceData[cp.nextTick - 1];
+    if(cp.currentPosition > 0) return cp.cash + last.Bid * cp.currentPosition * (1.0 - fees_rate);
+    if(cp.currentPosition < 0) return cp.cash - last.Ask * (-cp.currentPosition) * (1.0 + fees_rate);
+    return cp.cash;
+}
+
 // Load CSV data optimized for performance
 std::vector<PriceData> loadCSV(const std::string& filename) {
     std::vector<PriceData> data;
@@ -440,36 +496,160 @@ std::vector<PriceData> loadCSV(const std::string& filename) {
     return data;
 }
 
-// Thread worker function for grid search
-void workerThread(const std::vector<PriceData>& priceData, std::vector<ParameterSet> paramSets) {
-    for (auto& params : paramSets) {
-        if(params.short_window <= 0 || params.waiting_period <= 0) continue;
-        
-        runningTasks++;
-        BacktestResult result = runBacktest(priceData, params);
-        params.pnl = result.pnl;
-        
-        // Add to best results
-        {
-            std::lock_guard<std::mutex> lock(resultMutex);
-            bestResults.push(params);
-            // Keep only top 10 results
-            if (bestResults.size() > 10) {
-                // Create a new queue with just the top 10
-                std::priority_queue<ParameterSet> newQueue;
-                for (int i = 0; i < 10; i++) {
-                    if (bestResults.empty()) break;
-                    newQueue.push(bestResults.top());
-                    bestResults.pop();
+// Dense-grid checkpointing. The deduplicated grid is cut into CHUNK_SIZE
+// index ranges that workers take from a WorkStealingScheduler. A finished chunk stores its own
+// top 10 (the global top 10 is always among the chunks' top 10s) and then
+// sets its done flag with release ordering, so the checkpoint writer reads
+// finished chunks without taking any lock a worker could wait on.
+const size_t CHUNK_SIZE = 1024;
+const size_t KEEP_PER_CHUNK = 10;
+const char CHECKPOINT_MAGIC[8] = {'P', 'S', 'C', 'K', 'P', 'T', '0', '1'};
+
+struct ChunkResult {
+    uint32_t index;   // position in the deduplicated grid
+    double pnl;
+};
+
+std::vector<std::vector<ChunkResult>> chunkTop;
+std::vector<std::atomic<bool>> chunkDone;
+
+// Thread worker function for grid search: runs the chunks the scheduler
+// hands it, as positions in `pending` (the chunks not restored from a
+// checkpoint). Results go to the worker's own best list, so threads never
+// lock each other out.
+void workerThread(const std::vector<PriceData>& priceData, const std::vector<ParameterSet>& paramSets,
+                  const std::vector<size_t>& pending, WorkStealingScheduler& sched, unsigned int worker) {
+    BestResults& best = workerBest[worker];
+    sched.work(worker, [&](size_t first, size_t last) {
+        for (size_t p = first; p < last; p++) {
+            size_t c = pending[p];
+            size_t begin = c * CHUNK_SIZE;
+            size_t end = std::min(begin + CHUNK_SIZE, paramSets.size());
+            std::vector<ChunkResult> local;
+            for (size_t i = begin; i < end; i++) {
+                ParameterSet params = paramSets[i];
+                if(params.short_window <= 0 || params.waiting_period <= 0) {
+                    completedTasks++;
+                    continue;
                 }
-                bestResults = std::move(newQueue);
+
+                runningTasks++;
+                BacktestResult result = runBacktest(priceData, params);
+                params.pnl = result.pnl;
+                best.offer(params);
+                local.push_back({static_cast<uint32_t>(i), params.pnl});
+
+                // Update progress
+                completedTasks++;
+                runningTasks--;
             }
+
+            size_t keep = std::min(KEEP_PER_CHUNK, local.size());
+            std::partial_sort(local.begin(), local.begin() + keep, local.end(),
+                              [](const ChunkResult& a, const ChunkResult& b) { return a.pnl > b.pnl; });
+            local.resize(keep);
+            chunkTop[c] = std::move(local);
+            chunkDone[c].store(true, std::memory_order_release);
         }
-        
-        // Update progress
-        completedTasks++;
-        runningTasks--;
+    });
+}
+
+// FNV-1a over the grid's parameters, so a checkpoint is only resumed
+// against the exact grid it was written for
+uint64_t gridFingerprint(const std::vector<ParameterSet>& paramSets) {
+    uint64_t h = 1469598103934665603ull;
+    auto mix = [&h](const void* p, size_t n) {
+        const unsigned char* b = static_cast<const unsigned char*>(p);
+        for (size_t i = 0; i < n; i++) {
+            h ^= b[i];
+            h *= 1099511628211ull;
+        }
+    };
+    for (const auto& p : paramSets) {
+        mix(&p.short_window, sizeof(p.short_window));
+        mix(&p.waiting_period, sizeof(p.waiting_period));
+        mix(&p.hs_exit_change_threshold, sizeof(p.hs_exit_change_threshold));
+        mix(&p.ma_turn_threshold, sizeof(p.ma_turn_threshold));
+    }
+    return h;
+}
+
+// Checkpoint file layout (native endianness):
+//   magic[8], fingerprint u64, combos u64, chunk size u64, done chunks u64,
+//   then per done chunk: chunk u32, count u32, count x {index u32, pnl f64}
+// Written to path.tmp and renamed over path, so a kill mid-write leaves the
+// previous checkpoint intact. Returns the number of chunks saved, or -1.
+long writeCheckpoint(const std::string& path, uint64_t fingerprint, size_t combos) {
+    std::vector<uint32_t> done;
+    for (size_t c = 0; c < chunkTop.size(); c++) {
+        if (chunkDone[c].load(std::memory_order_acquire)) done.push_back(static_cast<uint32_t>(c));
+    }
+
+    std::string tmp = path + ".tmp";
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out) return -1;
+    uint64_t header[4] = {fingerprint, combos, CHUNK_SIZE, done.size()};
+    out.write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    for (uint32_t c : done) {
+        const std::vector<ChunkResult>& top = chunkTop[c];
+        uint32_t count = static_cast<uint32_t>(top.size());
+        out.write(reinterpret_cast<const char*>(&c), sizeof(c));
+        out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        for (const ChunkResult& r : top) {
+            out.write(reinterpret_cast<const char*>(&r.index), sizeof(r.index));
+            out.write(reinterpret_cast<const char*>(&r.pnl), sizeof(r.pnl));
+        }
+    }
+    out.close();
+    if (!out || std::rename(tmp.c_str(), path.c_str()) != 0) return -1;
+    return static_cast<long>(done.size());
+}
+
+// Marks the chunks saved in path as done and feeds their results back into
+// restoredBest and the progress counter. Returns the number of chunks
+// restored, or -1 if the file is missing, damaged or from another grid.
+long loadCheckpoint(const std::string& path, uint64_t fingerprint, const std::vector<ParameterSet>& paramSets) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return -1;
+    char magic[8];
+    uint64_t header[4];
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (!in || !std::equal(magic, magic + 8, CHECKPOINT_MAGIC) || header[0] != fingerprint ||
+        header[1] != paramSets.size() || header[2] != CHUNK_SIZE || header[3] > chunkTop.size()) {
+        return -1;
+    }
+
+    std::vector<std::pair<uint32_t, std::vector<ChunkResult>>> restored;
+    for (uint64_t k = 0; k < header[3]; k++) {
+        uint32_t c, count;
+        in.read(reinterpret_cast<char*>(&c), sizeof(c));
+        in.read(reinterpret_cast<char*>(&count), sizeof(count));
+        if (!in || c >= chunkTop.size() || count > KEEP_PER_CHUNK) return -1;
+        std::vector<ChunkResult> top(count);
+        for (ChunkResult& r : top) {
+            in.read(reinterpret_cast<char*>(&r.index), sizeof(r.index));
+            in.read(reinterpret_cast<char*>(&r.pnl), sizeof(r.pnl));
+            if (!in || r.index / CHUNK_SIZE != c) return -1;
+        }
+        restored.push_back({c, std::move(top)});
+    }
+
+    for (auto& entry : restored) {
+        uint32_t c = entry.first;
+        if (chunkDone[c].load()) continue;
+        for (const ChunkResult& r : entry.second) {
+            ParameterSet params = paramSets[r.index];
+            params.pnl = r.pnl;
+            restoredBest.offer(params);
+        }
+        size_t begin = c * CHUNK_SIZE;
+        completedTasks += static_cast<int>(std::min(begin + CHUNK_SIZE, paramSets.size()) - begin);
+        chunkTop[c] = std::move(entry.second);
+        chunkDone[c].store(true);
     }
+    return static_cast<long>(restored.size());
 }
 
 // Function to print progress bar
@@ -487,6 +667,10 @@ void printProgressBar(int width, float progress) {
 
 // Function to display top results
 void displayTopResults(int n = 3) {
+    // Merge the workers' latest snapshots (highest PnL first)
+    std::vector<ParameterSet> topResults = mergeSnapshots(workerBest, n, restoredBest);
+    if (topResults.empty()) return;
+    
     std::cout << "\nTop " << n << " parameter sets:" << std::endl;
     std::cout << std::setw(15) << "Short Window" 
               << std::setw(15) << "Wait Period" 
@@ -494,19 +678,6 @@ void displayTopResults(int n = 3) {
               << std::setw(15) << "MA Turn Thres" 
               << std::setw(15) << "PnL" << std::endl;
     
-    // Copy queue to array to display in order
-    std::vector<ParameterSet> topResults;
-    std::priority_queue<ParameterSet> tempQueue = bestResults;
-    
-    while (!tempQueue.empty() && topResults.size() < n) {
-        topResults.push_back(tempQueue.top());
-        tempQueue.pop();
-    }
-    
-    // Sort in descending order (highest PnL first)
-    std::sort(topResults.begin(), topResults.end(), 
-              [](const ParameterSet& a, const ParameterSet& b) { return a.pnl > b.pnl; });
-    
     for (const auto& result : topResults) {
         std::cout << std::setw(15) << result.short_window
                   << std::setw(15) << result.waiting_period
@@ -517,8 +688,258 @@ void displayTopResults(int n = 3) {
     std::cout << std::endl;
 }
 
+// Canonicalizes the grid: sorts by parameters and drops repeated sets
+// (static_cast<int> maps several multipliers to the same window), so each
+// distinct set is backtested once. Returns how many were dropped.
+size_t dedupParamSets(std::vector<ParameterSet>& paramSets) {
+    auto key = [](const ParameterSet& p) {
+        return std::make_tuple(p.short_window, p.waiting_period,
+                               p.hs_exit_change_threshold, p.ma_turn_threshold);
+    };
+    std::sort(paramSets.begin(), paramSets.end(),
+              [&](const ParameterSet& a, const ParameterSet& b) { return key(a) < key(b); });
+    auto last = std::unique(paramSets.begin(), paramSets.end(),
+                            [&](const ParameterSet& a, const ParameterSet& b) { return key(a) == key(b); });
+    size_t dropped = std::distance(last, paramSets.end());
+    paramSets.erase(last, paramSets.end());
+    return dropped;
+}
+
+// Backtests a refinement batch, spread over all cores
+void evaluateRefineBatch(const std::vector<PriceData>& priceData, std::vector<RefinePoint>& batch) {
+    unsigned int numThreads = std::thread::hardware_concurrency();
+    if (numThreads == 0) numThreads = 4;
+    WorkStealingScheduler sched(batch.size(), numThreads);
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < numThreads; t++) {
+        threads.emplace_back([&, t]() {
+            sched.work(t, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    ParameterSet params;
+                    params.short_window = batch[i].short_window;
+                    params.waiting_period = batch[i].waiting_period;
+                    params.hs_exit_change_threshold = batch[i].hs_exit_change_threshold;
+                    params.ma_turn_threshold = batch[i].ma_turn_threshold;
+                    batch[i].pnl = (params.short_window <= 0 || params.waiting_period <= 0)
+                        ? -std::numeric_limits<double>::infinity()
+                        : runBacktest(priceData, params).pnl;
+                }
+            });
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+// Successive halving over tick-prefix fidelity. Rung r runs every survivor
+// up to tick n / eta^(rungs-1-r), ranks them by PnL at that tick and keeps
+// the best 1/eta; the last rung covers the full series. Each survivor resumes
+// from its checkpoint at the previous rung instead of restarting at tick 0.
+// Returns the finalists sorted by full-series PnL (exactly runBacktest()'s).
+std::vector<ParameterSet> successiveHalving(const std::vector<PriceData>& priceData,
+                                            std::vector<ParameterSet> candidates,
+                                            int eta, int rungs, long long& ticksRun) {
+    std::vector<double> mids(priceData.size());
+    for(size_t i = 0; i < priceData.size(); i++) {
+        mids[i] = 0.5 * (priceData[i].Bid + priceData[i].Ask);
+    }
+    std::vector<BacktestCheckpoint> checkpoints(candidates.size());
+
+    unsigned int numThreads = std::thread::hardware_concurrency();
+    if (numThreads == 0) numThreads = 4;
+
+    ticksRun = 0;
+    size_t prevTick = 0;
+    for (int rung = 0; rung < rungs; rung++) {
+        size_t endTick = priceData.size();
+        for (int k = rung; k < rungs - 1; k++) endTick /= eta;
+        endTick = std::max<size_t>(endTick, 1);
+
+        // Resume every survivor to this rung's tick
+        WorkStealingScheduler sched(candidates.size(), numThreads);
+        std::vector<std::thread> threads;
+        for (unsigned int t = 0; t < numThreads; t++) {
+            threads.emplace_back([&, t]() {
+                sched.work(t, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; i++) {
+                        resumeBacktest(priceData, mids, candidates[i], checkpoints[i], endTick);
+                        candidates[i].pnl = checkpointPnl(priceData, checkpoints[i]);
+                    }
+                });
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        ticksRun += (long long)candidates.size() * (long long)(endTick - prevTick);
+        prevTick = endTick;
+
+        // Rank and keep the top 1/eta (all of them at the last rung)
+        std::vector<size_t> order(candidates.size());
+        for (size_t i = 0; i < order.size(); i++) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return candidates[a].pnl > candidates[b].pnl;
+        });
+        size_t keep = (rung == rungs - 1) ? order.size()
+                                          : std::max<size_t>(1, (order.size() + eta - 1) / eta);
+        std::cout << "  rung " << rung << ": " << candidates.size() << " candidates on "
+                  << endTick << " ticks, best PnL " << std::fixed << std::setprecision(2)
+                  << candidates[order[0]].pnl << ", keeping " << keep << std::endl;
+
+        std::vector<ParameterSet> nextCandidates;
+        std::vector<BacktestCheckpoint> nextCheckpoints;
+        for (size_t k = 0; k < keep; k++) {
+            nextCandidates.push_back(candidates[order[k]]);
+            nextCheckpoints.push_back(checkpoints[order[k]]);
+        }
+        candidates.swap(nextCandidates);
+        checkpoints.swap(nextCheckpoints);
+    }
+    return candidates;
+}
+
+// Thread-scaling benchmark for result collection. Runs an even sample of
+// the grid at 1, 2, 4, ... up to all cores, once with every result pushed
+// into a single mutex-guarded top 10 that is rebuilt whenever it overflows
+// (how workerThread used to collect results) and once into per-worker
+// WorkerTopK lists merged at the end. Each variant is timed on recording
+// alone (PnLs precomputed) and on backtest + record; "contended" is the
+// share of lock acquisitions that found the mutex held.
+void runScalingBenchmark(const std::vector<PriceData>& priceData,
+                         const std::vector<ParameterSet>& paramSets, size_t combos) {
+    std::vector<ParameterSet> sample;
+    double stride = std::max(1.0, static_cast<double>(paramSets.size()) / combos);
+    for (double k = 0; k < paramSets.size() && sample.size() < combos; k += stride) {
+        sample.push_back(paramSets[static_cast<size_t>(k)]);
+    }
+    unsigned int maxThreads = std::thread::hardware_concurrency();
+    if (maxThreads == 0) maxThreads = 4;
+    std::vector<unsigned int> counts;
+    for (unsigned int t = 1; t < maxThreads; t *= 2) counts.push_back(t);
+    counts.push_back(maxThreads);
+
+    // PnLs for the record-only passes, and the reference top 10
+    std::vector<ParameterSet> scored = sample;
+    for (auto& p : scored) p.pnl = runBacktest(priceData, p).pnl;
+    TopK<ParameterSet, 10> expected;
+    for (const auto& p : scored) expected.offer(p);
+
+    // Runs body(i, worker) for every sample index on t threads; returns seconds
+    auto timeRun = [&](unsigned int t, const std::function<void(size_t, unsigned int)>& body) {
+        std::atomic<size_t> next(0);
+        std::vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int w = 0; w < t; w++) {
+            threads.emplace_back([&, w]() {
+                for (size_t i = next++; i < sample.size(); i = next++) body(i, w);
+            });
+        }
+        for (auto& th : threads) th.join();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    struct Pass { double secs; double contended; bool sameTop; };
+    auto runLocked = [&](unsigned int t, bool backtest) {
+        std::mutex m;
+        std::priority_queue<ParameterSet> queue;
+        std::atomic<size_t> waits(0);
+        double secs = timeRun(t, [&](size_t i, unsigned int) {
+            ParameterSet params = sample[i];
+            params.pnl = backtest ? runBacktest(priceData, params).pnl : scored[i].pnl;
+            std::unique_lock<std::mutex> lock(m, std::try_to_lock);
+            if (!lock.owns_lock()) {
+                waits++;
+                lock.lock();
+            }
+            queue.push(params);
+            if (queue.size() > 10) {
+                std::priority_queue<ParameterSet> newQueue;
+                for (int k = 0; k < 10 && !queue.empty(); k++) {
+                    newQueue.push(queue.top());
+                    queue.pop();
+                }
+                queue = std::move(newQueue);
+            }
+        });
+        TopK<ParameterSet, 10> got;
+        for (; !queue.empty(); queue.pop()) got.offer(queue.top());
+        return Pass{secs, 100.0 * waits / sample.size(), got.sorted().front().pnl == expected.sorted().front().pnl};
+    };
+    auto runPerWorker = [&](unsigned int t, bool backtest) {
+        std::vector<BestResults> best(t);
+        double secs = timeRun(t, [&](size_t i, unsigned int w) {
+            ParameterSet params = sample[i];
+            params.pnl = backtest ? runBacktest(priceData, params).pnl : scored[i].pnl;
+            best[w].offer(params);
+        });
+        TopK<ParameterSet, 10> got;
+        for (const auto& b : best) got.merge(b.result());
+        return Pass{secs, 0.0, got.sorted().front().pnl == expected.sorted().front().pnl};
+    };
+
+    std::cout << "=== Result Collection Scaling (" << sample.size() << " combinations) ===" << std::endl;
+    for (bool backtest : {false, true}) {
+        std::cout << (backtest ? "\nBacktest + record:" : "\nRecord only:") << std::endl;
+        std::cout << std::setw(10) << "Threads"
+                  << std::setw(18) << "Locked combos/s"
+                  << std::setw(14) << "Contended"
+                  << std::setw(20) << "Per-worker combos/s"
+                  << std::setw(12) << "Speedup" << std::endl;
+        double base = 0.0;
+        for (unsigned int t : counts) {
+            Pass locked = runLocked(t, backtest);
+            Pass local = runPerWorker(t, backtest);
+            double rate = sample.size() / local.secs;
+            if (t == 1) base = rate;
+            std::cout << std::setw(10) << t
+                      << std::setw(18) << std::fixed << std::setprecision(0) << sample.size() / locked.secs
+                      << std::setw(13) << std::fixed << std::setprecision(1) << locked.contended << "%"
+                      << std::setw(20) << std::fixed << std::setprecision(0) << rate
+                      << std::setw(11) << std::fixed << std::setprecision(2) << rate / base << "x"
+                      << (locked.sameTop && local.sameTop ? "" : "  (best result differs!)") << std::endl;
+        }
+    }
+}
+
 // Main function
-int main() {
+int main(int argc, char* argv[]) {
+    // --refine: coarse-to-fine search instead of the dense grid
+    // --halving: successive halving over tick prefixes (--eta, --rungs)
+    // --compare-dense: run the dense grid afterwards and compare optima
+    // --checkpoint FILE / --checkpoint-every SEC: where and how often the
+    //   dense grid saves finished chunks; --resume skips the saved ones
+    //   (default file param_search.ckpt). Without either, nothing is saved
+    // --scaling N: time result collection on 1..all threads over N combos
+    bool refine = false;
+    bool halving = false;
+    int eta = 4;
+    int rungs = 3;
+    bool compareDense = false;
+    RefineConfig refineCfg;
+    std::string checkpointPath;
+    int checkpointEvery = 30;
+    bool resume = false;
+    size_t scalingCombos = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--refine") refine = true;
+        else if (arg == "--compare-dense") compareDense = true;
+        else if (arg == "--halving") halving = true;
+        else if (arg == "--eta" && i + 1 < argc) eta = std::max(2, std::stoi(argv[++i]));
+        else if (arg == "--rungs" && i + 1 < argc) rungs = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--refine-range" && i + 1 < argc) refineCfg.range = std::stoi(argv[++i]);
+        else if (arg == "--refine-keep" && i + 1 < argc) {
+            refineCfg.keepBest = refineCfg.keepStable = std::stoi(argv[++i]);
+        }
+        else if (arg == "--checkpoint" && i + 1 < argc) checkpointPath = argv[++i];
+        else if (arg == "--checkpoint-every" && i + 1 < argc) checkpointEvery = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--resume") resume = true;
+        else if (arg == "--scaling" && i + 1 < argc) scalingCombos = std::max(1, std::stoi(argv[++i]));
+    }
+    if (resume && checkpointPath.empty()) checkpointPath = "param_search.ckpt";
+    const bool checkpointing = !checkpointPath.empty();
+
     // Load CSV data
     const std::string csvFile = "./data/UEC.csv";
     std::vector<PriceData> priceData = loadCSV(csvFile);
@@ -547,6 +968,35 @@ int main() {
     std::cout << "Total Fees Paid = " << std::fixed << std::setprecision(2) << baselineResult.total_fees << std::endl;
     std::cout << std::endl;
     
+    // Coarse-to-fine refinement over the same percentage lattice
+    RefinePoint refined{};
+    size_t refineCount = 0;
+    if (refine) {
+        std::cout << "=== Coarse-to-Fine Refinement (+/-" << refineCfg.range << "%) ===" << std::endl;
+        GridRefiner refiner(refineCfg, [](const GridRefiner::Offsets& k) {
+            return RefinePoint{static_cast<int>(BASE_SHORT_WINDOW * (1.0 + (k[0] / 100.0))),
+                               static_cast<int>(BASE_WAITING_PERIOD * (1.0 + (k[1] / 100.0))),
+                               BASE_HS_EXIT_CHANGE_THRESHOLD * (1.0 + (k[2] / 100.0)),
+                               BASE_MA_TURN_THRESHOLD * (1.0 + (k[3] / 100.0)), 0.0};
+        });
+        RefinePoint best = refiner.run([&](std::vector<RefinePoint>& batch) {
+            evaluateRefineBatch(priceData, batch);
+        }, &std::cout);
+        refined = refiner.best(15);
+        refineCount = refiner.evaluations();
+
+        std::cout << "Refinement used " << refineCount << " backtests" << std::endl;
+        std::cout << "Best: SW=" << best.short_window << " WP=" << best.waiting_period
+                  << " HSX=" << std::fixed << std::setprecision(4) << best.hs_exit_change_threshold
+                  << " MAT=" << std::fixed << std::setprecision(4) << best.ma_turn_threshold
+                  << " PnL=" << std::fixed << std::setprecision(2) << best.pnl << std::endl;
+        std::cout << "Best within the +/-15% dense range: PnL=" << refined.pnl << std::endl;
+        if (!compareDense) {
+            return 0;
+        }
+        std::cout << std::endl;
+    }
+    
     // Generate 31 variations per parameter (-15% to +15% in 1% increments)
     std::vector<ParameterSet> allParamSets;
     
@@ -582,40 +1032,89 @@ int main() {
         }
     }
     
+    size_t gridSize = allParamSets.size();
+    size_t redundant = dedupParamSets(allParamSets);
     totalTasks = allParamSets.size();
     
     std::cout << "=== Starting Parameter Grid Search ===" << std::endl;
-    std::cout << "Number of parameter combinations: " << totalTasks << std::endl;
+    std::cout << "Number of parameter combinations: " << totalTasks
+              << " (" << gridSize << " grid points, " << redundant
+              << " redundant backtests skipped)" << std::endl;
     std::cout << "Parameter ranges:" << std::endl;
     std::cout << "  Short Window: " << short_window_values.front() << " to " << short_window_values.back() << std::endl;
     std::cout << "  Waiting Period: " << waiting_period_values.front() << " to " << waiting_period_values.back() << std::endl;
     std::cout << "  HS Exit Threshold: " << hs_exit_threshold_values.front() << " to " << hs_exit_threshold_values.back() << std::endl;
     std::cout << "  MA Turn Threshold: " << ma_turn_threshold_values.front() << " to " << ma_turn_threshold_values.back() << std::endl;
     
+    if (scalingCombos > 0) {
+        std::cout << std::endl;
+        runScalingBenchmark(priceData, allParamSets, scalingCombos);
+        return 0;
+    }
+    
+    // Successive halving instead of (or before) the full grid
+    ParameterSet halvingBest{};
+    long long halvingTicks = 0;
+    if (halving) {
+        std::cout << "\n=== Successive Halving (eta=" << eta << ", " << rungs << " rungs) ===" << std::endl;
+        std::vector<ParameterSet> finalists = successiveHalving(priceData, allParamSets, eta, rungs, halvingTicks);
+        halvingBest = finalists.front();
+        long long denseTicks = (long long)totalTasks * (long long)priceData.size();
+
+        std::cout << "Ticks simulated: " << halvingTicks << " vs " << denseTicks << " for the full grid ("
+                  << std::fixed << std::setprecision(1) << (100.0 * halvingTicks / denseTicks) << "%)" << std::endl;
+        std::cout << "Best: SW=" << halvingBest.short_window << " WP=" << halvingBest.waiting_period
+                  << " HSX=" << std::fixed << std::setprecision(4) << halvingBest.hs_exit_change_threshold
+                  << " MAT=" << std::fixed << std::setprecision(4) << halvingBest.ma_turn_threshold
+                  << " PnL=" << std::fixed << std::setprecision(2) << halvingBest.pnl << std::endl;
+        if (!compareDense) {
+            return 0;
+        }
+        std::cout << std::endl;
+    }
+    
     // Get the number of threads to use
     unsigned int numThreads = std::thread::hardware_concurrency();
     if (numThreads == 0) numThreads = 4; // Default to 4 if can't detect
     
     std::cout << "Using " << numThreads << " threads" << std::endl;
     
-    // Split work among threads
+    // Split the grid into chunks, restoring finished ones from a checkpoint
     std::vector<std::thread> threads;
-    std::vector<std::vector<ParameterSet>> threadWorkloads(numThreads);
+    size_t numChunks = (allParamSets.size() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    chunkTop.assign(numChunks, {});
+    chunkDone = std::vector<std::atomic<bool>>(numChunks);
+    workerBest = std::vector<BestResults>(numThreads);
+    uint64_t fingerprint = gridFingerprint(allParamSets);
+    if (resume) {
+        long restored = loadCheckpoint(checkpointPath, fingerprint, allParamSets);
+        if (restored < 0) {
+            std::cerr << "Cannot resume from " << checkpointPath
+                      << " (missing, damaged or written for another grid)" << std::endl;
+            return 1;
+        }
+        std::cout << "Resumed " << restored << "/" << numChunks << " chunks (" << completedTasks
+                  << " combinations) from " << checkpointPath << std::endl;
+    }
     
-    for (size_t i = 0; i < allParamSets.size(); i++) {
-        threadWorkloads[i % numThreads].push_back(allParamSets[i]);
+    std::vector<size_t> pending;
+    for (size_t c = 0; c < numChunks; c++) {
+        if (!chunkDone[c].load()) pending.push_back(c);
     }
     
     // Start the threads
     auto start_time = std::chrono::high_resolution_clock::now();
+    WorkStealingScheduler sched(pending.size(), numThreads);
     
     for (unsigned int i = 0; i < numThreads; i++) {
-        threads.emplace_back(workerThread, std::ref(priceData), threadWorkloads[i]);
+        threads.emplace_back(workerThread, std::cref(priceData), std::cref(allParamSets), std::cref(pending),
+                             std::ref(sched), i);
     }
     
     // Monitor progress and display top results
     const int progressBarWidth = 50;
     int lastPercent = 0;
+    auto lastCheckpoint = start_time;
     
     while (completedTasks < totalTasks) {
         float progress = static_cast<float>(completedTasks) / totalTasks;
@@ -627,10 +1126,16 @@ int main() {
         if (currentPercent != lastPercent || 
             (currentPercent < 10 && static_cast<int>(progress * 1000) % 10 == 0)) {
             lastPercent = currentPercent;
-            std::lock_guard<std::mutex> lock(resultMutex);
-            if (!bestResults.empty()) {
-                displayTopResults(3);
+            displayTopResults(3);
+        }
+        
+        // Save finished chunks; workers keep running meanwhile
+        auto now = std::chrono::high_resolution_clock::now();
+        if (checkpointing && now - lastCheckpoint >= std::chrono::seconds(checkpointEvery)) {
+            if (writeCheckpoint(checkpointPath, fingerprint, allParamSets.size()) < 0) {
+                std::cerr << "\nWarning: could not write checkpoint " << checkpointPath << std::endl;
             }
+            lastCheckpoint = now;
         }
         
         std::this_thread::sleep_for(std::chrono::milliseconds(500));
@@ -643,12 +1148,21 @@ int main() {
     for (auto& t : threads) {
         t.join();
     }
+    if (checkpointing) {
+        long savedChunks = writeCheckpoint(checkpointPath, fingerprint, allParamSets.size());
+        if (savedChunks < 0) {
+            std::cerr << "Warning: could not write checkpoint " << checkpointPath << std::endl;
+        } else {
+            std::cout << "Checkpoint: " << savedChunks << " chunks in " << checkpointPath << std::endl;
+        }
+    }
     
     auto end_time = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::seconds>(end_time - start_time).count();
     
     std::cout << "\n=== Grid Search Complete ===" << std::endl;
     std::cout << "Total time: " << duration << " seconds" << std::endl;
+    sched.report(std::cout);
     
     // Display final top 10 results
     std::cout << "\nTop 10 parameter sets:" << std::endl;
@@ -658,16 +1172,12 @@ int main() {
               << std::setw(15) << "MA Turn Thres" 
               << std::setw(15) << "PnL" << std::endl;
     
-    // Copy queue to array to display in order
-    std::vector<ParameterSet> topResults;
-    while (!bestResults.empty()) {
-        topResults.push_back(bestResults.top());
-        bestResults.pop();
+    // Merge the workers' best lists once, now that they have finished
+    TopK<ParameterSet, 10> best = restoredBest;
+    for (const auto& w : workerBest) {
+        best.merge(w.result());
     }
-    
-    // Sort in descending order (highest PnL first)
-    std::sort(topResults.begin(), topResults.end(), 
-              [](const ParameterSet& a, const ParameterSet& b) { return a.pnl > b.pnl; });
+    std::vector<ParameterSet> topResults = best.sorted();
     
     for (const auto& result : topResults) {
         std::cout << std::setw(15) << result.short_window
@@ -707,6 +1217,23 @@ int main() {
                   << std::setw(15) << std::fixed << std::setprecision(2) << improvement << "%" << std::endl;
     }
     
+    // Compare the refinement against the dense grid it replaces
+    if (refine && !topResults.empty()) {
+        std::cout << "\n=== Refinement vs Dense Grid ===" << std::endl;
+        std::cout << "Backtests: " << refineCount << " refined vs " << totalTasks << " dense ("
+                  << std::fixed << std::setprecision(1) << (100.0 * refineCount / totalTasks) << "%)" << std::endl;
+        std::cout << "Optimum PnL: " << std::fixed << std::setprecision(2) << refined.pnl
+                  << " refined vs " << topResults[0].pnl << " dense"
+                  << (refined.pnl == topResults[0].pnl ? " (same optimum)" : " (different optimum)") << std::endl;
+    }
+    
+    if (halving && !topResults.empty()) {
+        std::cout << "\n=== Successive Halving vs Dense Grid ===" << std::endl;
+        std::cout << "Optimum PnL: " << std::fixed << std::setprecision(2) << halvingBest.pnl
+                  << " halving vs " << topResults[0].pnl << " dense"
+                  << (halvingBest.pnl == topResults[0].pnl ? " (same optimum)" : " (different optimum)") << std::endl;
+    }
+    
     // Run the best parameter set once more with verbose output
     if (!topResults.empty()) {
         std::cout << "\n=== Running Best Parameter Set with Details ===" << std::endl;
@@ -11,10 +11,14 @@
 #include <tuple>
 #include <limits>
 #include <thread>
-#include <future>
-#include <mutex> // For protecting shared resources if any (primarily for collecting results)
 #include <numeric> // For std::accumulate
 #include <cmath>   // For std::isnan
+#include <cstdio>  // For std::sscanf
+
+#include <sys/resource.h> // For getrusage (peak RSS)
+
+#include "../../round 1/grid search/try2/include/ParamSampler.h" // Sobol / Latin hypercube sampling
+#include "../../round 1/grid search/try2/include/WorkStealing.h" // Range scheduler for the worker pool
 
 // --- Constants ---
 const std::string VP_SYMBOL = "VP";
@@ -112,6 +116,14 @@ public:
         price_history[etf_sym] = {};
     }
     
+    // Reuses this instance for another parameter set (run_backtest clears the history)
+    void set_params(int ravg_w, double pos_thresh, double neg_thresh, int order_qty) {
+        rolling_avg_window = ravg_w;
+        positive_diff_ma_threshold = pos_thresh;
+        negative_diff_ma_threshold = neg_thresh;
+        fixed_order_quantity = order_qty;
+    }
+
     void reset_internal_state() {
         difference_history.clear();
         timestamps_history.clear();
@@ -384,6 +396,17 @@ std::vector<PriceData> load_product_csv(const std::string& product_name) {
     return data_series;
 }
 
+// Peak resident set size of this process so far, in MB
+double peak_rss_mb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024.0 * 1024.0); // bytes
+#else
+    return usage.ru_maxrss / 1024.0; // kilobytes
+#endif
+}
+
 // --- Backtesting Function ---
 double run_backtest(
     TradingAlgorithm& algo, // Pass by reference to modify and retrieve history
@@ -495,9 +518,39 @@ double run_backtest(
 }
 
 
-int main() {
+int main(int argc, char* argv[]) {
     std::cout << std::fixed << std::setprecision(5); // For PnL output
 
+    // --- Optional sampling mode: --sample sobol|lhs [--samples N] [--seed S] [--shard i/N] ---
+    bool sample = false;
+    SampleMethod sample_method = SampleMethod::Sobol;
+    uint64_t sample_count = 1024;
+    uint64_t sample_seed = 1;
+    int shard_index = 0, shard_count = 1;
+    unsigned int num_threads = 0; // --threads N, 0 = all cores
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--sample" && i + 1 < argc) {
+            if (!ParamSampler::parseMethod(argv[++i], sample_method)) {
+                std::cerr << "Unknown sampling method: " << argv[i] << std::endl;
+                return 1;
+            }
+            sample = true;
+        } else if (arg == "--samples" && i + 1 < argc) {
+            sample_count = std::stoull(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            sample_seed = std::stoull(argv[++i]);
+        } else if (arg == "--shard" && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%d/%d", &shard_index, &shard_count) != 2 ||
+                shard_count < 1 || shard_index < 0 || shard_index >= shard_count) {
+                std::cerr << "--shard expects i/N with 0 <= i < N" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--threads" && i + 1 < argc) {
+            num_threads = static_cast<unsigned int>(std::max(1, std::stoi(argv[++i])));
+        }
+    }
+
     // --- Load Market Data (once) ---
     std::map<std::string, std::vector<PriceData>> all_market_data;
     std::vector<std::string> products_for_backtest = {VP_SYMBOL, "SHEEP", "ORE", "WHEAT"};
@@ -529,18 +582,36 @@ int main() {
     }
     std::vector<int> quantities = {100}; //{100};
 
-
-    for (int w : windows) {
-        for (double pt : pos_thresholds) {
-            for (double nt : neg_thresholds) {
-                if (nt >= pt) continue; // Basic sanity check
-                for (int q : quantities) {
-                    param_combos.push_back({w, pt, nt, q});
+    if (sample) {
+        // Same bounds as the grid lists above, drawn as a fixed budget of
+        // points. Point k depends only on k, so --shard i/N runs slice i
+        // of one shared sample.
+        ParamSampler sampler({{(double)windows.front(), (double)windows.back(), true},
+                              {pos_thresholds.front(), pos_thresholds.back(), false},
+                              {neg_thresholds.front(), neg_thresholds.back(), false},
+                              {(double)quantities.front(), (double)quantities.back(), true}},
+                             sample_method, sample_seed, sample_count);
+        auto range = ParamSampler::shard(sample_count, shard_index, shard_count);
+        for (uint64_t k = range.first; k < range.second; ++k) {
+            std::vector<double> x = sampler.point(k);
+            if (x[2] >= x[1]) continue; // Basic sanity check
+            param_combos.push_back({(int)x[0], x[1], x[2], (int)x[3]});
+        }
+        std::cout << "Sampled points " << range.first << "-" << range.second << " of " << sample_count
+                  << " (seed " << sample_seed << ")" << std::endl;
+    } else {
+        for (int w : windows) {
+            for (double pt : pos_thresholds) {
+                for (double nt : neg_thresholds) {
+                    if (nt >= pt) continue; // Basic sanity check
+                    for (int q : quantities) {
+                        param_combos.push_back({w, pt, nt, q});
+                    }
                 }
             }
         }
     }
-    
+
     if (param_combos.empty()) { // Default if fuzzing lists are empty (use Python values)
          param_combos.push_back({1, 33.0, -33.0, 100});
     }
@@ -554,31 +625,42 @@ int main() {
     int base_position_limit = 100;
     double base_fees = 0.002;
 
-    std::vector<std::future<BacktestResult>> futures;
-    std::mutex results_mutex;
-    std::vector<BacktestResult> all_results;
-
-    for (const auto& params_to_test : param_combos) {
-        futures.push_back(
-            std::async(std::launch::async, 
-                [&all_market_data, params_to_test, &base_ratios, base_intercept, &products_for_backtest, base_position_limit, base_fees]() {
-                TradingAlgorithm algo_instance(
-                    params_to_test.rolling_avg_window,
-                    params_to_test.positive_diff_ma_threshold,
-                    params_to_test.negative_diff_ma_threshold,
-                    params_to_test.fixed_order_quantity,
-                    base_ratios, base_intercept, VP_SYMBOL, COMPONENT_SYMBOLS
-                );
-                double pnl = run_backtest(algo_instance, all_market_data, products_for_backtest, base_position_limit, base_fees, false);
-                return BacktestResult{params_to_test, pnl};
-            })
-        );
+    // --- Run the combinations on a fixed pool of worker threads ---
+    // Each worker owns one TradingAlgorithm and reuses it for every
+    // combination it runs; results go straight into their slot.
+    if (num_threads == 0) num_threads = std::thread::hardware_concurrency();
+    if (num_threads == 0) num_threads = 4; // Fallback if hardware_concurrency fails
+    num_threads = static_cast<unsigned int>(std::min<size_t>(num_threads, param_combos.size()));
+
+    std::vector<BacktestResult> all_results(param_combos.size());
+    WorkStealingScheduler sched(param_combos.size(), num_threads);
+    std::vector<std::thread> workers;
+    workers.reserve(num_threads);
+    for (unsigned int w = 0; w < num_threads; ++w) {
+        workers.emplace_back([&, w]() {
+            TradingAlgorithm algo_instance(0, 0.0, 0.0, 0, base_ratios, base_intercept, VP_SYMBOL, COMPONENT_SYMBOLS);
+            sched.work(w, [&](size_t begin, size_t end) {
+                for (size_t k = begin; k < end; ++k) {
+                    const FuzzParams& params_to_test = param_combos[k];
+                    algo_instance.set_params(params_to_test.rolling_avg_window,
+                                             params_to_test.positive_diff_ma_threshold,
+                                             params_to_test.negative_diff_ma_threshold,
+                                             params_to_test.fixed_order_quantity);
+                    double pnl = run_backtest(algo_instance, all_market_data, products_for_backtest, base_position_limit, base_fees, false);
+                    all_results[k] = BacktestResult{params_to_test, pnl};
+                }
+            });
+        });
     }
-
-    for (auto& fut : futures) {
-        all_results.push_back(fut.get());
+    for (auto& t : workers) {
+        t.join();
     }
 
+    std::cout << "Ran " << all_results.size() << " combinations on " << num_threads
+              << " worker threads, peak RSS " << std::setprecision(1) << peak_rss_mb() << " MB"
+              << std::setprecision(5) << std::endl;
+    sched.report(std::cout);
+
     // --- Report Results ---
     std::cout << "\n--- Parameter Fuzzing Report ---" << std::endl;
     std::cout << std::left << std::setw(10) << "Window"